@@ -0,0 +1,278 @@
+// Замеры таблицы маршрутов и поиска по сгенерированной сети:
+//
+//   router_bench [stop_count bus_count max_bus_stops seed [graph_models]]
+//
+// По умолчанию 1200 остановок, 200 автобусов до 31 остановки, модели графа
+// stop_pairs,merged_stops,line (через запятую). Выводятся:
+//   - байты на ячейку таблицы маршрутов в каждом формате весов;
+//   - время построения таблицы в double Флойдом-Уоршеллом, блочным
+//     Флойдом-Уоршеллом и поисками Дейкстры из каждой вершины в одном
+//     потоке, затем двух последних по числу потоков до числа ядер, но не
+//     меньше четырёх;
+//   - число обработанных вершин на запрос у поиска Дейкстры и A*.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "generated_network.h"
+#include "json_reader.h"
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+using Graph = graph::DirectedWeightedGraph<double>;
+
+const size_t SAMPLE_COUNT = 2000;
+
+double secondsSince(Clock::time_point _start)
+{
+    return std::chrono::duration<double>(Clock::now() - _start).count();
+}
+
+std::vector<std::string> split(const std::string &_text, char _separator)
+{
+    std::vector<std::string> parts;
+    std::istringstream stream(_text);
+    for (std::string part; std::getline(stream, part, _separator);)
+    {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+// Случайные пары вершин ожидания остановок
+std::vector<std::pair<graph::VertexId, graph::VertexId>> samplePairs(const TransportRouter &_router)
+{
+    std::vector<graph::VertexId> vertexes;
+    for (const auto &[name, ids] : _router.getVertexes())
+    {
+        vertexes.push_back(ids.waiting);
+    }
+    std::sort(vertexes.begin(), vertexes.end());
+
+    std::mt19937 random(1);
+    std::uniform_int_distribution<size_t> random_vertex(0, vertexes.size() - 1);
+    std::vector<std::pair<graph::VertexId, graph::VertexId>> pairs;
+    for (size_t sample = 0; sample < SAMPLE_COUNT; ++sample)
+    {
+        pairs.emplace_back(vertexes[random_vertex(random)], vertexes[random_vertex(random)]);
+    }
+    return pairs;
+}
+
+void printTableBytes(const std::vector<std::pair<std::string, size_t>> &_vertex_counts)
+{
+    const std::vector<std::pair<std::string, size_t>> formats = {
+        {"optional<RouteInternalData>", sizeof(std::optional<graph::Router<double>::RouteInternalData>)},
+        {"double", graph::Router<double>::RoutesInternalData::BYTES_PER_CELL},
+        {"float", graph::Router<double, float>::RoutesInternalData::BYTES_PER_CELL},
+        {"fixed_point", graph::Router<double, uint32_t>::RoutesInternalData::BYTES_PER_CELL},
+    };
+
+    std::cout << "Routes table, bytes per cell and MB per graph\n";
+    for (const auto &[format, bytes] : formats)
+    {
+        std::cout << "  " << std::setw(28) << std::left << format << std::right << std::setw(3) << bytes;
+        for (const auto &[model, vertex_count] : _vertex_counts)
+        {
+            std::cout << "  " << model << ' '
+                      << static_cast<double>(vertex_count * vertex_count * bytes) / (1 << 20);
+        }
+        std::cout << '\n';
+    }
+}
+
+// Время построения таблицы, в _weights - веса маршрутов между _pairs
+double buildTable(const Graph &_graph, graph::AllPairsAlgorithm _algorithm, size_t _thread_count,
+                  const std::vector<std::pair<graph::VertexId, graph::VertexId>> &_pairs,
+                  std::vector<double> &_weights)
+{
+    const auto start = Clock::now();
+    const graph::Router<double> router(_graph, true, _algorithm, _thread_count);
+    const double seconds = secondsSince(start);
+
+    _weights.clear();
+    for (const auto &[from, to] : _pairs)
+    {
+        const auto route = router.BuildRoute(from, to);
+        _weights.push_back(route.has_value() ? route->weight : -1.0);
+    }
+    return seconds;
+}
+
+void benchTableBuild(const std::string &_model, const Graph &_graph, const TransportRouter &_router)
+{
+    struct Algorithm
+    {
+        std::string name;
+        graph::AllPairsAlgorithm algorithm;
+    };
+    const std::vector<Algorithm> algorithms = {
+        {"floyd_warshall", graph::AllPairsAlgorithm::FLOYD_WARSHALL},
+        {"blocked_floyd_warshall", graph::AllPairsAlgorithm::BLOCKED_FLOYD_WARSHALL},
+        {"parallel_dijkstra", graph::AllPairsAlgorithm::PARALLEL_DIJKSTRA},
+    };
+
+    // Не меньше четырёх потоков, чтобы на малом числе ядер была видна цена
+    // лишних потоков
+    std::vector<size_t> thread_counts;
+    const size_t max_threads = std::max<size_t>(4, std::thread::hardware_concurrency());
+    for (size_t threads = 2; threads < max_threads; threads *= 2)
+    {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    const auto pairs = samplePairs(_router);
+    std::vector<double> expected;
+    std::vector<double> weights;
+    std::cout << _model << ", " << _graph.GetVertexCount() << " vertices, "
+              << _graph.GetEdgeCount() << " edges\n";
+    for (const auto &[name, algorithm] : algorithms)
+    {
+        const bool is_reference = expected.empty();
+        const double seconds = buildTable(_graph, algorithm, 1, pairs, is_reference ? expected : weights);
+        double max_difference = 0.0;
+        for (size_t pair = 0; !is_reference && pair < pairs.size(); ++pair)
+        {
+            max_difference = std::max(max_difference, std::abs(weights[pair] - expected[pair]));
+        }
+        std::cout << "  " << std::setw(24) << std::left << name << std::right
+                  << "  1 thread  " << std::setw(8) << seconds << " s";
+        if (!is_reference)
+        {
+            std::cout << "  max difference " << max_difference;
+        }
+        std::cout << '\n';
+
+        if (algorithm == graph::AllPairsAlgorithm::FLOYD_WARSHALL)
+        {
+            continue;
+        }
+        for (const size_t threads : thread_counts)
+        {
+            std::cout << "  " << std::setw(24) << std::left << name << std::right << ' '
+                      << std::setw(2) << threads << " threads "
+                      << std::setw(8) << buildTable(_graph, algorithm, threads, pairs, weights) << " s\n";
+        }
+    }
+}
+
+// Поиск Дейкстры и A* с оценкой по расстоянию по прямой, как в режиме A_STAR
+void benchAStar(const std::string &_model, const Graph &_graph, const TransportRouter &_router)
+{
+    const graph::DijkstraRouter<double> router(_graph);
+    const auto &coordinates = _router.getVertexCoordinates();
+    const double min_time_per_meter = _router.getMinTimePerMeter();
+
+    size_t dijkstra_settled = 0;
+    size_t a_star_settled = 0;
+    size_t mismatches = 0;
+    const auto pairs = samplePairs(_router);
+    for (const auto &[from, to] : pairs)
+    {
+        const auto dijkstra_route = router.BuildRoute(from, to);
+        dijkstra_settled += router.GetSettledCount();
+
+        const geo::Coordinates target = coordinates[to];
+        const auto a_star_route = router.BuildRoute(from, to, [&](graph::VertexId _vertex)
+        {
+            return min_time_per_meter * geo::ComputeDistance(coordinates[_vertex], target);
+        });
+        a_star_settled += router.GetSettledCount();
+
+        if (dijkstra_route.has_value() != a_star_route.has_value() ||
+                (dijkstra_route.has_value() &&
+                 std::abs(dijkstra_route->weight - a_star_route->weight) > 1e-6 * dijkstra_route->weight))
+        {
+            ++mismatches;
+        }
+    }
+    std::cout << "  " << std::setw(13) << std::left << _model << std::right
+              << " Dijkstra " << std::setw(8) << static_cast<double>(dijkstra_settled) / pairs.size()
+              << "  A* " << std::setw(8) << static_cast<double>(a_star_settled) / pairs.size()
+              << "  route time mismatches " << mismatches << '\n';
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    generated::NetworkShape shape;
+    std::vector<std::string> models = {"stop_pairs", "merged_stops", "line"};
+    if (argc >= 5)
+    {
+        shape.stop_count = std::stoul(argv[1]);
+        shape.bus_count = std::stoul(argv[2]);
+        shape.max_bus_stops = std::stoul(argv[3]);
+        shape.seed = static_cast<uint32_t>(std::stoul(argv[4]));
+    }
+    if (argc >= 6)
+    {
+        models = split(argv[5], ',');
+    }
+    if (argc != 1 && argc != 5 && argc != 6)
+    {
+        std::cerr << "Usage: router_bench [stop_count bus_count max_bus_stops seed [graph_models]]\n";
+        return 1;
+    }
+
+    // Граф строится в режиме A_STAR: таблица не нужна, а координаты вершин
+    // и нижняя оценка времени проезда метра считаются вместе с графом
+    struct Network
+    {
+        explicit Network(json::Document _doc) :
+            doc(std::move(_doc))
+        {
+
+        }
+
+        json::Document doc;
+        TransportCatalogue catalogue;
+        renderer::MapRenderer render;
+        TransportRouter router;
+    };
+    std::vector<std::unique_ptr<Network>> networks;
+    std::vector<std::pair<std::string, size_t>> vertex_counts;
+    for (const auto &model : models)
+    {
+        networks.push_back(std::make_unique<Network>(
+            generated::generateNetwork(shape, json::Dict{{"bus_wait_time", 6}, {"bus_velocity", 30},
+                                                         {"router_mode", std::string("a_star")},
+                                                         {"graph_model", model}})));
+        Network &network = *networks.back();
+        reader::JsonReader reader(network.catalogue, network.render, network.router);
+        reader.parseBaseRequests(network.doc);
+        reader.parseRoutingSettings(network.doc);
+        network.router.createGraph(network.catalogue);
+        vertex_counts.emplace_back(model, network.router.getGraph().GetVertexCount());
+    }
+
+    std::cout << shape.stop_count << " stops, " << shape.bus_count << " buses, up to "
+              << shape.max_bus_stops << " stops per bus, seed " << shape.seed << "\n\n";
+    printTableBytes(vertex_counts);
+
+    std::cout << "\nRoutes table build\n";
+    for (size_t index = 0; index < models.size(); ++index)
+    {
+        benchTableBuild(models[index], networks[index]->router.getGraph(), networks[index]->router);
+    }
+
+    std::cout << "\nSettled vertices per query, " << SAMPLE_COUNT << " queries\n";
+    for (size_t index = 0; index < models.size(); ++index)
+    {
+        benchAStar(models[index], networks[index]->router.getGraph(), networks[index]->router);
+    }
+    return 0;
+}
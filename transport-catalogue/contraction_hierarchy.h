@@ -0,0 +1,747 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Иерархия сжатий (Contraction Hierarchies). Вершины по очереди сжимаются
+// в порядке возрастания важности, при сжатии вершины кратчайшие пути через
+// неё заменяются рёбрами-сокращениями. Запрос - двунаправленный Дейкстра,
+// идущий только вверх по рангу, найденный путь раскрывается в исходные рёбра.
+//
+// Дуги нумеруются так: [0, E) - рёбра исходного графа, E + i - сокращение i.
+template <typename Weight>
+class ContractionHierarchy {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    struct Shortcut {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        // Заменяемые дуги from -> середина и середина -> to
+        EdgeId first_arc;
+        EdgeId second_arc;
+    };
+
+    // Предподсчёт по графу
+    explicit ContractionHierarchy(const Graph& graph);
+
+    // Восстановление по ранее посчитанным рангам и сокращениям
+    ContractionHierarchy(const Graph& graph, std::vector<uint32_t> ranks,
+                         std::vector<Shortcut> shortcuts);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    // Маршруты от каждой вершины sources до каждой вершины targets, по строке
+    // на вершину sources. Поиск вниз из каждой цели раскладывает веса по
+    // корзинам пройденных вершин, поиск вверх из каждого начала просматривает
+    // корзины своих вершин: |sources| + |targets| поисков вместо
+    // |sources| * |targets|. Без with_edges рёбра маршрутов не раскрываются.
+    std::vector<std::optional<RouteInfo>> BuildRouteMatrix(const std::vector<VertexId>& sources,
+                                                           const std::vector<VertexId>& targets,
+                                                           bool with_edges) const;
+
+    const std::vector<uint32_t>& GetRanks() const;
+    const std::vector<Shortcut>& GetShortcuts() const;
+
+private:
+    // Дуга рабочего графа при сжатии (для входящих дуг vertex - начало дуги)
+    struct WorkArc {
+        VertexId vertex;
+        Weight weight;
+        EdgeId arc_id;
+    };
+
+    // Дуги графа поиска в формате CSR
+    struct SearchGraph {
+        std::vector<CompactId> offsets;
+        std::vector<CompactId> targets;
+        std::vector<Weight> weights;
+        std::vector<EdgeId> arc_ids;
+    };
+
+    struct QueueEntry {
+        Weight weight;
+        VertexId vertex;
+
+        bool operator>(const QueueEntry& other) const {
+            return weight > other.weight;
+        }
+    };
+
+    // Буферы одного направления поиска
+    struct SearchSpace {
+        std::vector<uint32_t> reached_epoch;
+        std::vector<Weight> weights;
+        std::vector<EdgeId> parent_arcs;
+        std::vector<QueueEntry> heap;
+    };
+
+    // Вес от вершины корзины до цели и дуга, по которой поиск из цели
+    // пришёл в вершину
+    struct BucketEntry {
+        uint32_t target_index;
+        Weight weight;
+        EdgeId parent_arc;
+    };
+
+    // Ограничения поиска свидетелей: при оценке приоритета поиск короче,
+    // лишние сокращения от этого не появляются - приоритет лишь приблизителен
+    static constexpr size_t PRIORITY_SETTLED_LIMIT = 20;
+    static constexpr size_t CONTRACTION_SETTLED_LIMIT = 200;
+    static constexpr EdgeId NO_ARC = std::numeric_limits<EdgeId>::max();
+    static constexpr Weight ZERO_WEIGHT{};
+
+    void Preprocess();
+    void AddWorkArc(VertexId from, VertexId to, Weight weight, EdgeId arc_id);
+    size_t CountShortcuts(VertexId vertex);
+    void ContractVertex(VertexId vertex);
+    template <typename OnShortcut>
+    void FindShortcuts(VertexId vertex, size_t settled_limit, OnShortcut&& on_shortcut);
+    void RunWitnessSearch(VertexId source, VertexId excluded, Weight limit,
+                          size_t target_count, size_t settled_limit);
+
+    void BuildSearchGraphs();
+    VertexId GetArcFrom(EdgeId arc_id) const;
+    VertexId GetArcTo(EdgeId arc_id) const;
+    void UnpackArc(EdgeId arc_id, std::vector<EdgeId>& edges) const;
+    bool SearchStep(const SearchGraph& search_graph, SearchSpace& space, const SearchSpace& other,
+                    std::optional<Weight>& best_weight, VertexId& meeting_vertex) const;
+    void StartSearch(SearchSpace& space, VertexId from) const;
+    // Полный поиск по графу поиска, on_settled(vertex, weight) для каждой
+    // окончательно обработанной вершины
+    template <typename OnSettled>
+    void SearchAll(const SearchGraph& search_graph, SearchSpace& space, VertexId from,
+                   OnSettled&& on_settled) const;
+
+    const Graph& graph_;
+    std::vector<uint32_t> ranks_;
+    std::vector<Shortcut> shortcuts_;
+
+    // Рабочие данные предподсчёта
+    std::vector<std::vector<WorkArc>> out_arcs_;
+    std::vector<std::vector<WorkArc>> in_arcs_;
+    std::vector<bool> is_contracted_;
+    std::vector<size_t> contracted_neighbors_;
+    std::vector<Weight> witness_weights_;
+    std::vector<uint32_t> witness_epoch_;
+    std::vector<uint32_t> witness_settled_epoch_;
+    std::vector<uint32_t> witness_target_epoch_;
+    std::vector<QueueEntry> witness_heap_;
+    uint32_t witness_search_ = 0;
+
+    // Граф поиска: forward_ - дуги вверх по рангу, backward_ - дуги вниз
+    // по рангу, развёрнутые для обратного поиска
+    SearchGraph forward_;
+    SearchGraph backward_;
+
+    mutable uint32_t epoch_ = 0;
+    mutable SearchSpace forward_space_;
+    mutable SearchSpace backward_space_;
+};
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph)
+    : graph_(graph)
+{
+    Preprocess();
+    BuildSearchGraphs();
+}
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph, std::vector<uint32_t> ranks,
+                                                   std::vector<Shortcut> shortcuts)
+    : graph_(graph)
+    , ranks_(std::move(ranks))
+    , shortcuts_(std::move(shortcuts))
+{
+    if (ranks_.size() != graph.GetVertexCount()) {
+        throw std::invalid_argument("Ranks do not match the graph");
+    }
+    BuildSearchGraphs();
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::AddWorkArc(VertexId from, VertexId to, Weight weight,
+                                              EdgeId arc_id) {
+    // Из параллельных дуг в рабочем графе нужна только самая лёгкая
+    for (auto& arc : out_arcs_[from]) {
+        if (arc.vertex != to) {
+            continue;
+        }
+        if (weight < arc.weight) {
+            arc.weight = weight;
+            arc.arc_id = arc_id;
+            for (auto& reverse_arc : in_arcs_[to]) {
+                if (reverse_arc.vertex == from) {
+                    reverse_arc.weight = weight;
+                    reverse_arc.arc_id = arc_id;
+                    break;
+                }
+            }
+        }
+        return;
+    }
+    out_arcs_[from].push_back({to, weight, arc_id});
+    in_arcs_[to].push_back({from, weight, arc_id});
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::RunWitnessSearch(VertexId source, VertexId excluded, Weight limit,
+                                                    size_t target_count, size_t settled_limit) {
+    witness_heap_.clear();
+    witness_epoch_[source] = witness_search_;
+    witness_weights_[source] = ZERO_WEIGHT;
+    witness_heap_.push_back({ZERO_WEIGHT, source});
+
+    // Поиск останавливается, когда все цели окончательно достигнуты
+    size_t settled_count = 0;
+    while (!witness_heap_.empty() && settled_count < settled_limit && target_count > 0) {
+        std::pop_heap(witness_heap_.begin(), witness_heap_.end(), std::greater<QueueEntry>{});
+        const QueueEntry entry = witness_heap_.back();
+        witness_heap_.pop_back();
+        if (witness_settled_epoch_[entry.vertex] == witness_search_
+            || witness_weights_[entry.vertex] < entry.weight) {
+            continue;
+        }
+        if (limit < entry.weight) {
+            break;
+        }
+        witness_settled_epoch_[entry.vertex] = witness_search_;
+        ++settled_count;
+        if (witness_target_epoch_[entry.vertex] == witness_search_) {
+            --target_count;
+        }
+
+        for (const auto& arc : out_arcs_[entry.vertex]) {
+            if (arc.vertex == excluded || is_contracted_[arc.vertex]) {
+                continue;
+            }
+            const Weight candidate_weight = entry.weight + arc.weight;
+            if (witness_epoch_[arc.vertex] != witness_search_
+                || candidate_weight < witness_weights_[arc.vertex]) {
+                witness_epoch_[arc.vertex] = witness_search_;
+                witness_weights_[arc.vertex] = candidate_weight;
+                witness_heap_.push_back({candidate_weight, arc.vertex});
+                std::push_heap(witness_heap_.begin(), witness_heap_.end(), std::greater<QueueEntry>{});
+            }
+        }
+    }
+}
+
+template <typename Weight>
+template <typename OnShortcut>
+void ContractionHierarchy<Weight>::FindShortcuts(VertexId vertex, size_t settled_limit,
+                                                 OnShortcut&& on_shortcut) {
+    for (const auto& in_arc : in_arcs_[vertex]) {
+        if (is_contracted_[in_arc.vertex]) {
+            continue;
+        }
+
+        if (++witness_search_ == 0) {
+            std::fill(witness_epoch_.begin(), witness_epoch_.end(), 0);
+            std::fill(witness_settled_epoch_.begin(), witness_settled_epoch_.end(), 0);
+            std::fill(witness_target_epoch_.begin(), witness_target_epoch_.end(), 0);
+            witness_search_ = 1;
+        }
+
+        std::optional<Weight> max_weight;
+        size_t target_count = 0;
+        for (const auto& out_arc : out_arcs_[vertex]) {
+            if (is_contracted_[out_arc.vertex] || out_arc.vertex == in_arc.vertex) {
+                continue;
+            }
+            if (!max_weight || *max_weight < out_arc.weight) {
+                max_weight = out_arc.weight;
+            }
+            witness_target_epoch_[out_arc.vertex] = witness_search_;
+            ++target_count;
+        }
+        if (!max_weight) {
+            continue;
+        }
+
+        RunWitnessSearch(in_arc.vertex, vertex, in_arc.weight + *max_weight,
+                         target_count, settled_limit);
+
+        for (const auto& out_arc : out_arcs_[vertex]) {
+            if (is_contracted_[out_arc.vertex] || out_arc.vertex == in_arc.vertex) {
+                continue;
+            }
+            const Weight via_weight = in_arc.weight + out_arc.weight;
+            const bool has_witness = witness_epoch_[out_arc.vertex] == witness_search_
+                                     && !(via_weight < witness_weights_[out_arc.vertex]);
+            if (!has_witness) {
+                on_shortcut(in_arc, out_arc, via_weight);
+            }
+        }
+    }
+}
+
+template <typename Weight>
+size_t ContractionHierarchy<Weight>::CountShortcuts(VertexId vertex) {
+    size_t count = 0;
+    FindShortcuts(vertex, PRIORITY_SETTLED_LIMIT, [&count](const WorkArc&, const WorkArc&, Weight) {
+        ++count;
+    });
+    return count;
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::ContractVertex(VertexId vertex) {
+    std::vector<Shortcut> new_shortcuts;
+    FindShortcuts(vertex, CONTRACTION_SETTLED_LIMIT,
+                  [&](const WorkArc& in_arc, const WorkArc& out_arc, Weight via_weight) {
+        new_shortcuts.push_back({in_arc.vertex, out_arc.vertex, via_weight,
+                                 in_arc.arc_id, out_arc.arc_id});
+    });
+
+    is_contracted_[vertex] = true;
+    for (const auto& shortcut : new_shortcuts) {
+        const EdgeId arc_id = graph_.GetEdgeCount() + shortcuts_.size();
+        shortcuts_.push_back(shortcut);
+        AddWorkArc(shortcut.from, shortcut.to, shortcut.weight, arc_id);
+    }
+
+    // Сжатая вершина больше не участвует в поиске свидетелей:
+    // убираем её из списков соседей, чтобы не просматривать впустую
+    const auto erase_vertex = [vertex](std::vector<WorkArc>& arcs) {
+        arcs.erase(std::remove_if(arcs.begin(), arcs.end(), [vertex](const WorkArc& arc) {
+            return arc.vertex == vertex;
+        }), arcs.end());
+    };
+    for (const auto& arc : out_arcs_[vertex]) {
+        ++contracted_neighbors_[arc.vertex];
+        erase_vertex(in_arcs_[arc.vertex]);
+    }
+    for (const auto& arc : in_arcs_[vertex]) {
+        ++contracted_neighbors_[arc.vertex];
+        erase_vertex(out_arcs_[arc.vertex]);
+    }
+    out_arcs_[vertex].clear();
+    in_arcs_[vertex].clear();
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::Preprocess() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    out_arcs_.assign(vertex_count, {});
+    in_arcs_.assign(vertex_count, {});
+    is_contracted_.assign(vertex_count, false);
+    contracted_neighbors_.assign(vertex_count, 0);
+    witness_weights_.assign(vertex_count, ZERO_WEIGHT);
+    witness_epoch_.assign(vertex_count, 0);
+    witness_settled_epoch_.assign(vertex_count, 0);
+    witness_target_epoch_.assign(vertex_count, 0);
+    ranks_.assign(vertex_count, 0);
+    shortcuts_.clear();
+
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        if (edge.from != edge.to && !graph_.IsEdgeRemoved(edge_id)) {
+            AddWorkArc(edge.from, edge.to, edge.weight, edge_id);
+        }
+    }
+
+    // Приоритет - разность рёбер плюс число уже сжатых соседей;
+    // приоритеты пересчитываются лениво при извлечении
+    using Priority = std::pair<long long, VertexId>;
+    const auto compute_priority = [this](VertexId vertex) {
+        const long long degree = static_cast<long long>(in_arcs_[vertex].size() + out_arcs_[vertex].size());
+        return static_cast<long long>(CountShortcuts(vertex)) - degree
+               + static_cast<long long>(contracted_neighbors_[vertex]);
+    };
+
+    std::priority_queue<Priority, std::vector<Priority>, std::greater<Priority>> queue;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        queue.push({compute_priority(vertex), vertex});
+    }
+
+    uint32_t next_rank = 0;
+    while (!queue.empty()) {
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+        if (is_contracted_[vertex]) {
+            continue;
+        }
+
+        const long long priority = compute_priority(vertex);
+        if (!queue.empty() && queue.top().first < priority) {
+            queue.push({priority, vertex});
+            continue;
+        }
+
+        ContractVertex(vertex);
+        ranks_[vertex] = next_rank++;
+    }
+
+    out_arcs_.clear();
+    in_arcs_.clear();
+    is_contracted_.clear();
+    contracted_neighbors_.clear();
+    witness_weights_.clear();
+    witness_epoch_.clear();
+    witness_settled_epoch_.clear();
+    witness_target_epoch_.clear();
+    witness_heap_.clear();
+}
+
+template <typename Weight>
+VertexId ContractionHierarchy<Weight>::GetArcFrom(EdgeId arc_id) const {
+    return arc_id < graph_.GetEdgeCount() ? graph_.GetEdge(arc_id).from
+                                          : shortcuts_[arc_id - graph_.GetEdgeCount()].from;
+}
+
+template <typename Weight>
+VertexId ContractionHierarchy<Weight>::GetArcTo(EdgeId arc_id) const {
+    return arc_id < graph_.GetEdgeCount() ? graph_.GetEdge(arc_id).to
+                                          : shortcuts_[arc_id - graph_.GetEdgeCount()].to;
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::BuildSearchGraphs() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    const size_t arc_count = graph_.GetEdgeCount() + shortcuts_.size();
+
+    const auto arc_weight = [this](EdgeId arc_id) {
+        return arc_id < graph_.GetEdgeCount() ? graph_.GetEdge(arc_id).weight
+                                              : shortcuts_[arc_id - graph_.GetEdgeCount()].weight;
+    };
+
+    // Вверх по рангу - в прямой граф у начала дуги, вниз - в обратный у конца
+    const auto build = [&](SearchGraph& search_graph, bool is_forward) {
+        const auto owner = [&](EdgeId arc_id) {
+            return is_forward ? GetArcFrom(arc_id) : GetArcTo(arc_id);
+        };
+        const auto other = [&](EdgeId arc_id) {
+            return is_forward ? GetArcTo(arc_id) : GetArcFrom(arc_id);
+        };
+        const auto is_included = [&](EdgeId arc_id) {
+            if (arc_id < graph_.GetEdgeCount() && graph_.IsEdgeRemoved(arc_id)) {
+                return false;
+            }
+            return ranks_.at(owner(arc_id)) < ranks_.at(other(arc_id));
+        };
+
+        search_graph.offsets.assign(vertex_count + 1, 0);
+        for (EdgeId arc_id = 0; arc_id < arc_count; ++arc_id) {
+            if (is_included(arc_id)) {
+                ++search_graph.offsets[owner(arc_id) + 1];
+            }
+        }
+        for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+            search_graph.offsets[vertex + 1] += search_graph.offsets[vertex];
+        }
+
+        const size_t size = search_graph.offsets.back();
+        search_graph.targets.resize(size);
+        search_graph.weights.resize(size);
+        search_graph.arc_ids.resize(size);
+        std::vector<CompactId> positions(search_graph.offsets.begin(),
+                                         std::prev(search_graph.offsets.end()));
+        for (EdgeId arc_id = 0; arc_id < arc_count; ++arc_id) {
+            if (!is_included(arc_id)) {
+                continue;
+            }
+            const CompactId position = positions[owner(arc_id)]++;
+            search_graph.targets[position] = static_cast<CompactId>(other(arc_id));
+            search_graph.weights[position] = arc_weight(arc_id);
+            search_graph.arc_ids[position] = arc_id;
+        }
+    };
+
+    build(forward_, true);
+    build(backward_, false);
+
+    for (SearchSpace* space : {&forward_space_, &backward_space_}) {
+        space->reached_epoch.assign(vertex_count, 0);
+        space->weights.assign(vertex_count, ZERO_WEIGHT);
+        space->parent_arcs.assign(vertex_count, NO_ARC);
+        space->heap.clear();
+    }
+}
+
+template <typename Weight>
+bool ContractionHierarchy<Weight>::SearchStep(const SearchGraph& search_graph, SearchSpace& space,
+                                              const SearchSpace& other,
+                                              std::optional<Weight>& best_weight,
+                                              VertexId& meeting_vertex) const {
+    while (!space.heap.empty()) {
+        std::pop_heap(space.heap.begin(), space.heap.end(), std::greater<QueueEntry>{});
+        const QueueEntry entry = space.heap.back();
+        space.heap.pop_back();
+        if (space.weights[entry.vertex] < entry.weight) {
+            continue;
+        }
+        // Поиск в направлении окончен: дальше только пути не короче найденного
+        if (best_weight && !(entry.weight < *best_weight)) {
+            space.heap.clear();
+            return false;
+        }
+
+        if (other.reached_epoch[entry.vertex] == epoch_) {
+            const Weight weight = entry.weight + other.weights[entry.vertex];
+            if (!best_weight || weight < *best_weight) {
+                best_weight = weight;
+                meeting_vertex = entry.vertex;
+            }
+        }
+
+        for (CompactId position = search_graph.offsets[entry.vertex];
+             position < search_graph.offsets[entry.vertex + 1]; ++position) {
+            const VertexId target = search_graph.targets[position];
+            const Weight candidate_weight = entry.weight + search_graph.weights[position];
+            if (space.reached_epoch[target] != epoch_ || candidate_weight < space.weights[target]) {
+                space.reached_epoch[target] = epoch_;
+                space.weights[target] = candidate_weight;
+                space.parent_arcs[target] = search_graph.arc_ids[position];
+                space.heap.push_back({candidate_weight, target});
+                std::push_heap(space.heap.begin(), space.heap.end(), std::greater<QueueEntry>{});
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::StartSearch(SearchSpace& space, VertexId from) const {
+    if (++epoch_ == 0) {
+        std::fill(forward_space_.reached_epoch.begin(), forward_space_.reached_epoch.end(), 0);
+        std::fill(backward_space_.reached_epoch.begin(), backward_space_.reached_epoch.end(), 0);
+        epoch_ = 1;
+    }
+    space.heap.clear();
+    space.reached_epoch[from] = epoch_;
+    space.weights[from] = ZERO_WEIGHT;
+    space.parent_arcs[from] = NO_ARC;
+    space.heap.push_back({ZERO_WEIGHT, from});
+}
+
+template <typename Weight>
+template <typename OnSettled>
+void ContractionHierarchy<Weight>::SearchAll(const SearchGraph& search_graph, SearchSpace& space,
+                                             VertexId from, OnSettled&& on_settled) const {
+    StartSearch(space, from);
+    while (!space.heap.empty()) {
+        std::pop_heap(space.heap.begin(), space.heap.end(), std::greater<QueueEntry>{});
+        const QueueEntry entry = space.heap.back();
+        space.heap.pop_back();
+        if (space.weights[entry.vertex] < entry.weight) {
+            continue;
+        }
+        on_settled(entry.vertex, entry.weight);
+
+        for (CompactId position = search_graph.offsets[entry.vertex];
+             position < search_graph.offsets[entry.vertex + 1]; ++position) {
+            const VertexId target = search_graph.targets[position];
+            const Weight candidate_weight = entry.weight + search_graph.weights[position];
+            if (space.reached_epoch[target] != epoch_ || candidate_weight < space.weights[target]) {
+                space.reached_epoch[target] = epoch_;
+                space.weights[target] = candidate_weight;
+                space.parent_arcs[target] = search_graph.arc_ids[position];
+                space.heap.push_back({candidate_weight, target});
+                std::push_heap(space.heap.begin(), space.heap.end(), std::greater<QueueEntry>{});
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::UnpackArc(EdgeId arc_id, std::vector<EdgeId>& edges) const {
+    std::vector<EdgeId> stack{arc_id};
+    while (!stack.empty()) {
+        const EdgeId current = stack.back();
+        stack.pop_back();
+        if (current < graph_.GetEdgeCount()) {
+            edges.push_back(current);
+            continue;
+        }
+        const auto& shortcut = shortcuts_[current - graph_.GetEdgeCount()];
+        stack.push_back(shortcut.second_arc);
+        stack.push_back(shortcut.first_arc);
+    }
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchy<Weight>::RouteInfo>
+ContractionHierarchy<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    // Оба направления работают в одной эпохе, чтобы видеть вершины друг друга
+    StartSearch(forward_space_, from);
+    backward_space_.heap.clear();
+    backward_space_.reached_epoch[to] = epoch_;
+    backward_space_.weights[to] = ZERO_WEIGHT;
+    backward_space_.parent_arcs[to] = NO_ARC;
+    backward_space_.heap.push_back({ZERO_WEIGHT, to});
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+    bool forward_active = true;
+    bool backward_active = true;
+    while (forward_active || backward_active) {
+        if (forward_active) {
+            forward_active = SearchStep(forward_, forward_space_, backward_space_,
+                                        best_weight, meeting_vertex);
+        }
+        if (backward_active) {
+            backward_active = SearchStep(backward_, backward_space_, forward_space_,
+                                         best_weight, meeting_vertex);
+        }
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> arcs;
+    for (VertexId vertex = meeting_vertex; forward_space_.parent_arcs[vertex] != NO_ARC; ) {
+        const EdgeId arc_id = forward_space_.parent_arcs[vertex];
+        arcs.push_back(arc_id);
+        vertex = GetArcFrom(arc_id);
+    }
+    std::reverse(arcs.begin(), arcs.end());
+    for (VertexId vertex = meeting_vertex; backward_space_.parent_arcs[vertex] != NO_ARC; ) {
+        const EdgeId arc_id = backward_space_.parent_arcs[vertex];
+        arcs.push_back(arc_id);
+        vertex = GetArcTo(arc_id);
+    }
+
+    std::vector<EdgeId> edges;
+    for (const EdgeId arc_id : arcs) {
+        UnpackArc(arc_id, edges);
+    }
+
+    return RouteInfo{*best_weight, std::move(edges)};
+}
+
+template <typename Weight>
+std::vector<std::optional<typename ContractionHierarchy<Weight>::RouteInfo>>
+ContractionHierarchy<Weight>::BuildRouteMatrix(const std::vector<VertexId>& sources,
+                                               const std::vector<VertexId>& targets,
+                                               bool with_edges) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    for (const auto& vertexes : {std::cref(sources), std::cref(targets)}) {
+        for (const VertexId vertex : vertexes.get()) {
+            if (vertex >= vertex_count) {
+                throw std::out_of_range("Vertex id is out of range");
+            }
+        }
+    }
+
+    // Корзины в формате CSR: сначала записи всех поисков из целей,
+    // затем раскладка по вершинам подсчётом
+    std::vector<std::pair<VertexId, BucketEntry>> entries;
+    for (size_t target_index = 0; target_index < targets.size(); ++target_index) {
+        SearchAll(backward_, backward_space_, targets[target_index], [&](VertexId vertex, Weight weight) {
+            entries.push_back({vertex, BucketEntry{static_cast<uint32_t>(target_index), weight,
+                                                   backward_space_.parent_arcs[vertex]}});
+        });
+    }
+    std::vector<size_t> bucket_offsets(vertex_count + 1, 0);
+    for (const auto& [vertex, entry] : entries) {
+        ++bucket_offsets[vertex + 1];
+    }
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        bucket_offsets[vertex + 1] += bucket_offsets[vertex];
+    }
+    std::vector<BucketEntry> buckets(entries.size());
+    {
+        std::vector<size_t> positions(bucket_offsets.begin(), std::prev(bucket_offsets.end()));
+        for (const auto& [vertex, entry] : entries) {
+            buckets[positions[vertex]++] = entry;
+        }
+    }
+    std::vector<std::pair<VertexId, BucketEntry>>().swap(entries);
+
+    // Вершина корзины, из которой поиск из цели target_index пришёл в vertex
+    const auto find_bucket_entry = [&](VertexId vertex, uint32_t target_index) -> const BucketEntry& {
+        const auto begin = buckets.begin() + bucket_offsets[vertex];
+        const auto end = buckets.begin() + bucket_offsets[vertex + 1];
+        return *std::find_if(begin, end, [target_index](const BucketEntry& entry) {
+            return entry.target_index == target_index;
+        });
+    };
+
+    std::vector<std::optional<RouteInfo>> routes(sources.size() * targets.size());
+    std::vector<VertexId> meeting_vertexes(targets.size());
+    for (size_t source_index = 0; source_index < sources.size(); ++source_index) {
+        const auto row = routes.begin() + source_index * targets.size();
+        SearchAll(forward_, forward_space_, sources[source_index], [&](VertexId vertex, Weight weight) {
+            for (size_t position = bucket_offsets[vertex]; position < bucket_offsets[vertex + 1]; ++position) {
+                const BucketEntry& entry = buckets[position];
+                const Weight candidate_weight = weight + entry.weight;
+                auto& route = row[entry.target_index];
+                if (!route || candidate_weight < route->weight) {
+                    route = RouteInfo{candidate_weight, {}};
+                    meeting_vertexes[entry.target_index] = vertex;
+                }
+            }
+        });
+
+        if (!with_edges) {
+            continue;
+        }
+        for (uint32_t target_index = 0; target_index < targets.size(); ++target_index) {
+            auto& route = row[target_index];
+            if (!route) {
+                continue;
+            }
+            std::vector<EdgeId> arcs;
+            for (VertexId vertex = meeting_vertexes[target_index];
+                 forward_space_.parent_arcs[vertex] != NO_ARC; ) {
+                const EdgeId arc_id = forward_space_.parent_arcs[vertex];
+                arcs.push_back(arc_id);
+                vertex = GetArcFrom(arc_id);
+            }
+            std::reverse(arcs.begin(), arcs.end());
+            for (VertexId vertex = meeting_vertexes[target_index]; ; ) {
+                const EdgeId arc_id = find_bucket_entry(vertex, target_index).parent_arc;
+                if (arc_id == NO_ARC) {
+                    break;
+                }
+                arcs.push_back(arc_id);
+                vertex = GetArcTo(arc_id);
+            }
+            for (const EdgeId arc_id : arcs) {
+                UnpackArc(arc_id, route->edges);
+            }
+        }
+    }
+
+    return routes;
+}
+
+template <typename Weight>
+const std::vector<uint32_t>& ContractionHierarchy<Weight>::GetRanks() const {
+    return ranks_;
+}
+
+template <typename Weight>
+const std::vector<typename ContractionHierarchy<Weight>::Shortcut>&
+ContractionHierarchy<Weight>::GetShortcuts() const {
+    return shortcuts_;
+}
+
+}  // namespace graph
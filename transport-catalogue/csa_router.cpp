@@ -0,0 +1,200 @@
+#include "csa_router.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+
+namespace
+{
+
+const double INFINITE_TIME = std::numeric_limits<double>::infinity();
+
+} // namespace
+
+void CsaRouter::build(const TransportCatalogue &_catalogue, double _velocity)
+{
+    stop_names_.clear();
+    stop_indexes_.clear();
+    trip_buses_.clear();
+
+    for (const auto *stop : _catalogue.getSortedUsedStops())
+    {
+        stop_indexes_[stop->name_] = static_cast<StopIndex>(stop_names_.size());
+        stop_names_.push_back(stop->name_);
+    }
+
+    std::vector<std::pair<Connection, uint32_t>> connections;
+    for (const auto *bus : _catalogue.getSortedBuses())
+    {
+        if (bus->departures_.empty())
+        {
+            continue;
+        }
+        appendTrips(bus->route_, *bus, _catalogue, _velocity, connections);
+        if (!bus->is_circul_)
+        {
+            appendTrips({bus->route_.rbegin(), bus->route_.rend()}, *bus,
+                        _catalogue, _velocity, connections);
+        }
+    }
+
+    if (connections.size() >= NONE || trip_buses_.size() >= NONE)
+    {
+        throw std::length_error("Too many connections in the timetable");
+    }
+
+    std::sort(connections.begin(), connections.end(), [](const auto &_lhs, const auto &_rhs)
+    {
+        return std::tie(_lhs.first.departure, _lhs.first.arrival, _lhs.first.trip) <
+                std::tie(_rhs.first.departure, _rhs.first.arrival, _rhs.first.trip);
+    });
+
+    connections_.clear();
+    connections_.reserve(connections.size());
+    connection_positions_.clear();
+    connection_positions_.reserve(connections.size());
+    for (const auto &[connection, position] : connections)
+    {
+        connections_.push_back(connection);
+        connection_positions_.push_back(position);
+    }
+
+    arrivals_.assign(stop_names_.size(), INFINITE_TIME);
+    legs_.assign(stop_names_.size(), Leg{});
+    trip_boards_.assign(trip_buses_.size(), NONE);
+    reached_stops_.clear();
+    boarded_trips_.clear();
+}
+
+void CsaRouter::appendTrips(const std::vector<std::string_view> &_stops,
+                            const domain::Bus &_bus,
+                            const TransportCatalogue &_catalogue,
+                            double _velocity,
+                            std::vector<std::pair<Connection, uint32_t>> &_connections)
+{
+    // Время от начальной остановки одинаково для всех рейсов направления
+    std::vector<double> offsets(_stops.size(), 0.0);
+    for (size_t position = 0; position + 1 < _stops.size(); ++position)
+    {
+        offsets[position + 1] = offsets[position] +
+                _catalogue.getDistancesBetweenStops({_stops[position],
+                                                     _stops[position + 1]}).value() / _velocity;
+    }
+
+    for (const double departure : _bus.departures_)
+    {
+        const auto trip = static_cast<uint32_t>(trip_buses_.size());
+        trip_buses_.push_back(_bus.name_);
+
+        for (size_t position = 0; position + 1 < _stops.size(); ++position)
+        {
+            _connections.emplace_back(Connection{departure + offsets[position],
+                                                 departure + offsets[position + 1],
+                                                 stop_indexes_.at(_stops[position]),
+                                                 stop_indexes_.at(_stops[position + 1]),
+                                                 trip},
+                                      static_cast<uint32_t>(position));
+        }
+    }
+}
+
+std::optional<std::pair<double, std::vector<domain::RouteItem>>>
+CsaRouter::buildRoute(std::string_view _from, std::string_view _to, double _departure_time) const
+{
+    if (stop_indexes_.count(_from) == 0U || stop_indexes_.count(_to) == 0U)
+    {
+        return {};
+    }
+
+    const StopIndex source = stop_indexes_.at(_from);
+    const StopIndex target = stop_indexes_.at(_to);
+
+    for (const StopIndex stop : reached_stops_)
+    {
+        arrivals_[stop] = INFINITE_TIME;
+        legs_[stop] = Leg{};
+    }
+    reached_stops_.clear();
+    for (const uint32_t trip : boarded_trips_)
+    {
+        trip_boards_[trip] = NONE;
+    }
+    boarded_trips_.clear();
+
+    arrivals_[source] = _departure_time;
+    reached_stops_.push_back(source);
+
+    const auto first = std::lower_bound(connections_.begin(), connections_.end(), _departure_time,
+                                        [](const Connection &_connection, double _time)
+    {
+        return _connection.departure < _time;
+    });
+
+    for (auto index = static_cast<uint32_t>(std::distance(connections_.begin(), first));
+         index < connections_.size(); ++index)
+    {
+        const Connection &connection = connections_[index];
+        // Позже прибытия в цель соединения её уже не улучшат
+        if (connection.departure >= arrivals_[target])
+        {
+            break;
+        }
+
+        uint32_t &board = trip_boards_[connection.trip];
+        if (board == NONE)
+        {
+            if (arrivals_[connection.from] > connection.departure)
+            {
+                continue;
+            }
+            board = index;
+            boarded_trips_.push_back(connection.trip);
+        }
+
+        if (connection.arrival < arrivals_[connection.to])
+        {
+            if (arrivals_[connection.to] == INFINITE_TIME)
+            {
+                reached_stops_.push_back(connection.to);
+            }
+            arrivals_[connection.to] = connection.arrival;
+            legs_[connection.to] = Leg{board, index};
+        }
+    }
+
+    if (arrivals_[target] == INFINITE_TIME)
+    {
+        return {};
+    }
+
+    std::pair<double, std::vector<domain::RouteItem>> output;
+    output.first = arrivals_[target] - _departure_time;
+
+    auto &items = output.second;
+    for (StopIndex stop = target; stop != source; )
+    {
+        const Leg &leg = legs_[stop];
+        const Connection &board = connections_[leg.board];
+        const Connection &alight = connections_[leg.alight];
+
+        items.emplace_back(domain::BusRouteInfo{
+                               trip_buses_[board.trip],
+                               static_cast<int>(connection_positions_[leg.alight] -
+                                                connection_positions_[leg.board] + 1),
+                               alight.arrival - board.departure});
+        items.emplace_back(domain::WaitInfo{stop_names_[board.from],
+                                            board.departure - arrivals_[board.from]});
+
+        stop = board.from;
+    }
+    std::reverse(items.begin(), items.end());
+
+    return output;
+}
+
+size_t CsaRouter::getConnectionCount() const
+{
+    return connections_.size();
+}
@@ -0,0 +1,82 @@
+#ifndef CSAROUTER_H
+#define CSAROUTER_H
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "transport_catalogue.h"
+
+// Поиск самого раннего прибытия по расписаниям рейсов (Connection Scan).
+// Каждый перегон каждого рейса - соединение, соединения лежат одним
+// массивом по возрастанию отправления, и запрос просматривает его подряд
+// от времени отправления, пока соединения не станут позже прибытия в цель.
+// Пересадка занимает любое время от нуля, ожидание - разница между
+// прибытием на остановку и отправлением рейса, bus_wait_time не учитывается.
+class CsaRouter
+{
+public:
+    CsaRouter() = default;
+
+    // Рейсы - отправления domain::Bus::departures_, время перегона -
+    // расстояние, делённое на _velocity (м/мин)
+    void build(const TransportCatalogue &_catalogue, double _velocity);
+
+    // Маршрут с отправлением из _from не раньше _departure_time (минуты от
+    // начала суток). Время маршрута - от _departure_time до прибытия в _to
+    std::optional<std::pair<double, std::vector<domain::RouteItem>>>
+    buildRoute(std::string_view _from, std::string_view _to, double _departure_time) const;
+
+    size_t getConnectionCount() const;
+
+private:
+    using StopIndex = uint32_t;
+
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // Горячие данные просмотра, 32 байта на соединение
+    struct Connection
+    {
+        double departure = 0.0;
+        double arrival = 0.0;
+        StopIndex from = 0;
+        StopIndex to = 0;
+        uint32_t trip = 0;
+    };
+
+    // Как доехали до остановки: соединения посадки и высадки
+    struct Leg
+    {
+        uint32_t board = NONE;
+        uint32_t alight = NONE;
+    };
+
+    void appendTrips(const std::vector<std::string_view> &_stops,
+                     const domain::Bus &_bus,
+                     const TransportCatalogue &_catalogue,
+                     double _velocity,
+                     std::vector<std::pair<Connection, uint32_t>> &_connections);
+
+    std::vector<std::string_view> stop_names_;
+    std::unordered_map<std::string_view, StopIndex> stop_indexes_;
+
+    // Имя автобуса каждого рейса
+    std::vector<std::string_view> trip_buses_;
+
+    std::vector<Connection> connections_;
+
+    // Номер перегона соединения в рейсе, нужен только для вывода маршрута
+    std::vector<uint32_t> connection_positions_;
+
+    // Буферы поиска, переиспользуются между запросами
+    mutable std::vector<double> arrivals_;
+    mutable std::vector<Leg> legs_;
+    mutable std::vector<uint32_t> trip_boards_;
+    mutable std::vector<StopIndex> reached_stops_;
+    mutable std::vector<uint32_t> boarded_trips_;
+};
+
+#endif // CSAROUTER_H
@@ -0,0 +1,329 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace graph {
+
+// Поиск Дейкстры от одной вершины на каждый запрос. В отличие от Router
+// ничего не хранит для пар вершин: буферы по вершинам и куча выделяются
+// один раз и переиспользуются между запросами, устаревшие значения
+// отличаются от актуальных по номеру поиска (эпохе).
+//
+// С потенциалом поиск становится A*: в куче вершины упорядочены по сумме
+// веса от начала и нижней оценки веса до цели.
+template <typename Weight>
+class DijkstraRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    explicit DijkstraRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    // potential(vertex) - нижняя оценка веса пути от vertex до to. Оценка должна
+    // быть согласованной: potential(u) <= weight(u, v) + potential(v)
+    template <typename Potential>
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, const Potential& potential) const;
+
+    // Маршрут с весами рёбер weigh(edge_id, edge_to, edge_weight) вместо весов
+    // графа, std::nullopt закрывает ребро. Новые веса должны быть неотрицательными
+    template <typename EdgeWeigher>
+    std::optional<RouteInfo> BuildReweightedRoute(VertexId from, VertexId to, const EdgeWeigher& weigh) const;
+
+    // Маршруты из from до каждой вершины targets одним поиском, который
+    // останавливается, когда обработаны все цели. Без with_edges рёбра
+    // маршрутов не восстанавливаются.
+    std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from, const std::vector<VertexId>& targets,
+                                                      bool with_edges) const;
+
+    // Поиск из from по всем вершинам с весом не больше budget: вершины
+    // дальше budget в кучу не попадают, и поиск не выходит за их границу
+    void SearchWithin(VertexId from, Weight budget) const;
+
+    // Вес вершины, обработанной последним поиском
+    std::optional<Weight> GetSettledWeight(VertexId vertex) const;
+
+    // Число вершин, обработанных последним поиском
+    size_t GetSettledCount() const;
+
+private:
+    struct QueueEntry {
+        Weight weight;
+        VertexId vertex;
+
+        bool operator>(const QueueEntry& other) const {
+            return weight > other.weight;
+        }
+    };
+
+    // weigh(edge_id, edge_to, edge_weight) - вес ребра в поиске или
+    // std::nullopt, если по ребру пройти нельзя
+    template <typename Potential, typename EdgeWeigher>
+    std::optional<RouteInfo> FindRoute(VertexId from, VertexId to, const Potential& potential,
+                                       const EdgeWeigher& weigh) const;
+
+    void StartSearch(VertexId from, Weight potential) const;
+    bool IsSettled(VertexId vertex) const;
+    std::vector<EdgeId> RestoreEdges(VertexId to) const;
+    bool IsReached(VertexId vertex) const;
+    void Reach(VertexId vertex, Weight weight, Weight potential,
+               std::optional<EdgeId> prev_edge) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+
+    mutable uint32_t epoch_ = 0;
+    mutable std::vector<uint32_t> reached_epoch_;
+    mutable std::vector<uint32_t> settled_epoch_;
+    mutable std::vector<Weight> weights_;
+    mutable std::vector<Weight> potentials_;
+    mutable std::vector<std::optional<EdgeId>> prev_edges_;
+    mutable std::vector<QueueEntry> heap_;
+    mutable size_t settled_count_ = 0;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+    , reached_epoch_(graph.GetVertexCount(), 0)
+    , settled_epoch_(graph.GetVertexCount(), 0)
+    , weights_(graph.GetVertexCount(), ZERO_WEIGHT)
+    , potentials_(graph.GetVertexCount(), ZERO_WEIGHT)
+    , prev_edges_(graph.GetVertexCount())
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+void DijkstraRouter<Weight>::StartSearch(VertexId from, Weight potential) const {
+    if (++epoch_ == 0) {
+        std::fill(reached_epoch_.begin(), reached_epoch_.end(), 0);
+        std::fill(settled_epoch_.begin(), settled_epoch_.end(), 0);
+        epoch_ = 1;
+    }
+    heap_.clear();
+    settled_count_ = 0;
+    Reach(from, ZERO_WEIGHT, potential, std::nullopt);
+}
+
+template <typename Weight>
+bool DijkstraRouter<Weight>::IsReached(VertexId vertex) const {
+    return reached_epoch_[vertex] == epoch_;
+}
+
+template <typename Weight>
+void DijkstraRouter<Weight>::Reach(VertexId vertex, Weight weight, Weight potential,
+                                   std::optional<EdgeId> prev_edge) const {
+    reached_epoch_[vertex] = epoch_;
+    weights_[vertex] = weight;
+    potentials_[vertex] = potential;
+    prev_edges_[vertex] = prev_edge;
+    heap_.push_back({weight + potential, vertex});
+    std::push_heap(heap_.begin(), heap_.end(), std::greater<QueueEntry>{});
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo>
+DijkstraRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    return BuildRoute(from, to, [](VertexId) {
+        return ZERO_WEIGHT;
+    });
+}
+
+template <typename Weight>
+template <typename Potential>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo>
+DijkstraRouter<Weight>::BuildRoute(VertexId from, VertexId to, const Potential& potential) const {
+    return FindRoute(from, to, potential, [](EdgeId, VertexId, const Weight& edge_weight) {
+        return std::optional<Weight>(edge_weight);
+    });
+}
+
+template <typename Weight>
+template <typename EdgeWeigher>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo>
+DijkstraRouter<Weight>::BuildReweightedRoute(VertexId from, VertexId to, const EdgeWeigher& weigh) const {
+    return FindRoute(from, to, [](VertexId) {
+        return ZERO_WEIGHT;
+    }, weigh);
+}
+
+template <typename Weight>
+template <typename Potential, typename EdgeWeigher>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo>
+DijkstraRouter<Weight>::FindRoute(VertexId from, VertexId to, const Potential& potential,
+                                  const EdgeWeigher& weigh) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    StartSearch(from, potential(from));
+    while (!heap_.empty()) {
+        std::pop_heap(heap_.begin(), heap_.end(), std::greater<QueueEntry>{});
+        const QueueEntry entry = heap_.back();
+        heap_.pop_back();
+
+        if (settled_epoch_[entry.vertex] == epoch_
+            || entry.weight > weights_[entry.vertex] + potentials_[entry.vertex]) {
+            continue;
+        }
+        settled_epoch_[entry.vertex] = epoch_;
+        ++settled_count_;
+        if (entry.vertex == to) {
+            break;
+        }
+
+        const Weight vertex_weight = weights_[entry.vertex];
+        graph_.ForEachOutgoingEdge(entry.vertex, [&](EdgeId edge_id, VertexId edge_to,
+                                                     const Weight& edge_weight) {
+            const std::optional<Weight> weight = weigh(edge_id, edge_to, edge_weight);
+            if (!weight) {
+                return;
+            }
+            const Weight candidate_weight = vertex_weight + *weight;
+            if (!IsReached(edge_to)) {
+                Reach(edge_to, candidate_weight, potential(edge_to), edge_id);
+            } else if (candidate_weight < weights_[edge_to]) {
+                Reach(edge_to, candidate_weight, potentials_[edge_to], edge_id);
+            }
+        });
+    }
+
+    if (!IsSettled(to)) {
+        return std::nullopt;
+    }
+
+    return RouteInfo{weights_[to], RestoreEdges(to)};
+}
+
+template <typename Weight>
+bool DijkstraRouter<Weight>::IsSettled(VertexId vertex) const {
+    return settled_epoch_[vertex] == epoch_;
+}
+
+template <typename Weight>
+std::vector<EdgeId> DijkstraRouter<Weight>::RestoreEdges(VertexId to) const {
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = prev_edges_[to];
+         edge_id;
+         edge_id = prev_edges_[graph_.GetEdge(*edge_id).from])
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+    return edges;
+}
+
+template <typename Weight>
+std::vector<std::optional<typename DijkstraRouter<Weight>::RouteInfo>>
+DijkstraRouter<Weight>::BuildRoutes(VertexId from, const std::vector<VertexId>& targets,
+                                    bool with_edges) const {
+    if (from >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    for (const VertexId to : targets) {
+        if (to >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+    }
+
+    // Повторяющиеся цели считаются один раз
+    std::vector<VertexId> unique_targets(targets);
+    std::sort(unique_targets.begin(), unique_targets.end());
+    unique_targets.erase(std::unique(unique_targets.begin(), unique_targets.end()), unique_targets.end());
+
+    StartSearch(from, ZERO_WEIGHT);
+    size_t remaining_targets = unique_targets.size();
+    while (!heap_.empty() && remaining_targets > 0) {
+        std::pop_heap(heap_.begin(), heap_.end(), std::greater<QueueEntry>{});
+        const QueueEntry entry = heap_.back();
+        heap_.pop_back();
+
+        if (IsSettled(entry.vertex) || entry.weight > weights_[entry.vertex]) {
+            continue;
+        }
+        settled_epoch_[entry.vertex] = epoch_;
+        ++settled_count_;
+        if (std::binary_search(unique_targets.begin(), unique_targets.end(), entry.vertex)) {
+            --remaining_targets;
+        }
+
+        const Weight vertex_weight = weights_[entry.vertex];
+        graph_.ForEachOutgoingEdge(entry.vertex, [&](EdgeId edge_id, VertexId edge_to,
+                                                     const Weight& edge_weight) {
+            const Weight candidate_weight = vertex_weight + edge_weight;
+            if (!IsReached(edge_to) || candidate_weight < weights_[edge_to]) {
+                Reach(edge_to, candidate_weight, ZERO_WEIGHT, edge_id);
+            }
+        });
+    }
+
+    std::vector<std::optional<RouteInfo>> routes(targets.size());
+    for (size_t index = 0; index < targets.size(); ++index) {
+        const VertexId to = targets[index];
+        if (IsSettled(to)) {
+            routes[index] = RouteInfo{weights_[to], with_edges ? RestoreEdges(to) : std::vector<EdgeId>{}};
+        }
+    }
+    return routes;
+}
+
+template <typename Weight>
+void DijkstraRouter<Weight>::SearchWithin(VertexId from, Weight budget) const {
+    if (from >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    StartSearch(from, ZERO_WEIGHT);
+    while (!heap_.empty()) {
+        std::pop_heap(heap_.begin(), heap_.end(), std::greater<QueueEntry>{});
+        const QueueEntry entry = heap_.back();
+        heap_.pop_back();
+
+        if (IsSettled(entry.vertex) || entry.weight > weights_[entry.vertex]) {
+            continue;
+        }
+        settled_epoch_[entry.vertex] = epoch_;
+        ++settled_count_;
+
+        const Weight vertex_weight = weights_[entry.vertex];
+        graph_.ForEachOutgoingEdge(entry.vertex, [&](EdgeId edge_id, VertexId edge_to,
+                                                     const Weight& edge_weight) {
+            const Weight candidate_weight = vertex_weight + edge_weight;
+            if (candidate_weight <= budget
+                && (!IsReached(edge_to) || candidate_weight < weights_[edge_to])) {
+                Reach(edge_to, candidate_weight, ZERO_WEIGHT, edge_id);
+            }
+        });
+    }
+}
+
+template <typename Weight>
+std::optional<Weight> DijkstraRouter<Weight>::GetSettledWeight(VertexId vertex) const {
+    if (vertex >= graph_.GetVertexCount() || !IsSettled(vertex)) {
+        return std::nullopt;
+    }
+    return weights_[vertex];
+}
+
+template <typename Weight>
+size_t DijkstraRouter<Weight>::GetSettledCount() const {
+    return settled_count_;
+}
+
+}  // namespace graph
@@ -12,6 +12,7 @@ Bus::Bus(const Bus &other)
     this->number_unique_stops_ = other.number_unique_stops_;
     this->route_length_ = other.route_length_;
     this->curvature_ = other.curvature_;
+    this->departures_ = other.departures_;
 }
 
 Bus::Bus(Bus &&other) noexcept
@@ -22,6 +23,7 @@ Bus::Bus(Bus &&other) noexcept
     std::swap(this->is_circul_, other.is_circul_);
     std::swap(this->route_length_, other.route_length_);
     std::swap(this->number_unique_stops_, other.number_unique_stops_);
+    std::swap(this->departures_, other.departures_);
 }
 
 Bus &Bus::operator =(const Bus &other)
@@ -31,6 +33,8 @@ Bus &Bus::operator =(const Bus &other)
     this->is_circul_ = other.is_circul_;
     this->route_ = other.route_;
     this->number_unique_stops_ = other.number_unique_stops_;
+    this->curvature_ = other.curvature_;
+    this->departures_ = other.departures_;
     return *this;
 }
 
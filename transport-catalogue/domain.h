@@ -3,6 +3,7 @@
 
 #include <string>
 #include <set>
+#include <variant>
 #include <vector>
 
 namespace domain
@@ -53,6 +54,9 @@ struct Bus
     size_t number_unique_stops_ = 0;
     long double route_length_ = 0.0;
     double curvature_ = 0.0;
+    // Отправления рейсов с начальной остановки в минутах от начала суток,
+    // у некольцевого автобуса - с обеих конечных. Пусто - без расписания
+    std::vector<double> departures_;
 };
 
 struct BusStat
@@ -89,5 +93,7 @@ struct WaitInfo
     double time = 0.0;
 };
 
+using RouteItem = std::variant<std::monostate, WaitInfo, BusRouteInfo>;
+
 } // namespace domain
 #endif // DOMAIN_H
@@ -2,13 +2,37 @@
 
 #include "ranges.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
 namespace graph {
 
+// С GRAPH_COMPACT_IDS номера вершин и рёбер 32-битные: рёбра, списки
+// инцидентности и рабочие массивы маршрутизаторов компактнее, а граф
+// ограничен 2^32 - 1 вершинами и рёбрами
+#ifdef GRAPH_COMPACT_IDS
+using VertexId = uint32_t;
+using EdgeId = uint32_t;
+#else
 using VertexId = size_t;
 using EdgeId = size_t;
+#endif
+// Идентификаторы в компактном (замороженном) представлении графа
+using CompactId = uint32_t;
+
+// Вес, обозначающий отсутствие маршрута
+template <typename Weight>
+constexpr Weight InfiniteWeight() {
+    if constexpr (std::numeric_limits<Weight>::has_infinity) {
+        return std::numeric_limits<Weight>::infinity();
+    } else {
+        return std::numeric_limits<Weight>::max();
+    }
+}
 
 template <typename Weight>
 struct Edge {
@@ -33,21 +57,60 @@ public:
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+    // Строит компактное представление исходящих рёбер (CSR): смещения по
+    // вершинам и отдельные плотные массивы концов, весов и номеров рёбер.
+    // Порядок рёбер вершины сохраняется. Добавление ребра снимает заморозку.
+    void Freeze();
+    bool IsFrozen() const;
+
+    // Меняет вес ребра, в замороженном графе - без пересборки
+    void SetEdgeWeight(EdgeId edge_id, const Weight& weight);
+
+    // Убирает ребро из исходящих рёбер вершины. Номер ребра остаётся занятым,
+    // вес становится бесконечным, обходы рёбер по номерам такие рёбра
+    // пропускают. Снимает заморозку.
+    void RemoveEdge(EdgeId edge_id);
+    bool IsEdgeRemoved(EdgeId edge_id) const;
+
+    // Вызывает action(edge_id, to, weight) для каждого исходящего ребра вершины.
+    // После Freeze() читает данные последовательно, без проверок границ.
+    template <typename Action>
+    void ForEachOutgoingEdge(VertexId vertex, Action&& action) const;
+
 private:
     std::vector<Edge<Weight>> edges_;
     std::vector<IncidenceList> incidence_lists_;
+
+    bool is_frozen_ = false;
+    std::vector<CompactId> offsets_;
+    std::vector<CompactId> targets_;
+    std::vector<Weight> weights_;
+    std::vector<CompactId> edge_ids_;
 };
 
 template <typename Weight>
 DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
     : incidence_lists_(vertex_count) {
+    if (vertex_count > std::numeric_limits<VertexId>::max()) {
+        throw std::length_error("Too many vertices for VertexId");
+    }
 }
 
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+    if (edges_.size() >= std::numeric_limits<EdgeId>::max()) {
+        throw std::length_error("Too many edges for EdgeId");
+    }
     edges_.push_back(edge);
-    const EdgeId id = edges_.size() - 1;
+    const EdgeId id = static_cast<EdgeId>(edges_.size() - 1);
     incidence_lists_.at(edge.from).push_back(id);
+    if (is_frozen_) {
+        is_frozen_ = false;
+        offsets_.clear();
+        targets_.clear();
+        weights_.clear();
+        edge_ids_.clear();
+    }
     return id;
 }
 
@@ -71,4 +134,91 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, const Weight& weight) {
+    auto& edge = edges_.at(edge_id);
+    edge.weight = weight;
+    if (!is_frozen_) {
+        return;
+    }
+    for (CompactId slot = offsets_[edge.from]; slot < offsets_[edge.from + 1]; ++slot) {
+        if (edge_ids_[slot] == edge_id) {
+            weights_[slot] = weight;
+            return;
+        }
+    }
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::RemoveEdge(EdgeId edge_id) {
+    auto& edge = edges_.at(edge_id);
+    auto& incidence_list = incidence_lists_[edge.from];
+    incidence_list.erase(std::remove(incidence_list.begin(), incidence_list.end(), edge_id),
+                         incidence_list.end());
+    edge.weight = InfiniteWeight<Weight>();
+    if (is_frozen_) {
+        is_frozen_ = false;
+        offsets_.clear();
+        targets_.clear();
+        weights_.clear();
+        edge_ids_.clear();
+    }
+}
+
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::IsEdgeRemoved(EdgeId edge_id) const {
+    return edges_.at(edge_id).weight == InfiniteWeight<Weight>();
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::Freeze() {
+    const size_t vertex_count = incidence_lists_.size();
+    if (vertex_count >= std::numeric_limits<CompactId>::max()
+        || edges_.size() >= std::numeric_limits<CompactId>::max()) {
+        throw std::length_error("Graph is too large for 32-bit compact ids");
+    }
+
+    offsets_.assign(vertex_count + 1, 0);
+    targets_.resize(edges_.size());
+    weights_.resize(edges_.size());
+    edge_ids_.resize(edges_.size());
+
+    CompactId slot = 0;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        offsets_[vertex] = slot;
+        for (const EdgeId edge_id : incidence_lists_[vertex]) {
+            const auto& edge = edges_[edge_id];
+            targets_[slot] = static_cast<CompactId>(edge.to);
+            weights_[slot] = edge.weight;
+            edge_ids_[slot] = static_cast<CompactId>(edge_id);
+            ++slot;
+        }
+    }
+    offsets_[vertex_count] = slot;
+    is_frozen_ = true;
+}
+
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+    return is_frozen_;
+}
+
+template <typename Weight>
+template <typename Action>
+void DirectedWeightedGraph<Weight>::ForEachOutgoingEdge(VertexId vertex, Action&& action) const {
+    if (is_frozen_) {
+        const CompactId end = offsets_[vertex + 1];
+        for (CompactId slot = offsets_[vertex]; slot < end; ++slot) {
+            action(static_cast<EdgeId>(edge_ids_[slot]), static_cast<VertexId>(targets_[slot]),
+                   weights_[slot]);
+        }
+        return;
+    }
+
+    for (const EdgeId edge_id : incidence_lists_.at(vertex)) {
+        const auto& edge = edges_[edge_id];
+        action(edge_id, edge.to, edge.weight);
+    }
+}
 }  // namespace graph
\ No newline at end of file
@@ -0,0 +1,293 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Метки хабов (2-hop labeling). У каждой вершины v есть исходящая метка -
+// хабы h с весами d(v, h) - и входящая - хабы h с весами d(h, v). Вес пути
+// from -> to - минимум d(from, h) + d(h, to) по общим хабам меток, метки
+// отсортированы по хабу и объединяются за один проход.
+//
+// Метки строятся поиском с отсечениями (pruned landmark labeling): вершины
+// по очереди становятся хабами в порядке убывания степени, поиск из хаба не
+// идёт дальше вершин, вес пути до которых уже даётся имеющимися метками.
+template <typename Weight>
+class HubLabels {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    struct LabelEntry {
+        // Номер хаба в порядке обработки
+        CompactId hub;
+        Weight weight;
+    };
+
+    // Метки всех вершин подряд, метка вершины v - [offsets[v], offsets[v + 1])
+    struct Labels {
+        std::vector<CompactId> offsets;
+        std::vector<LabelEntry> entries;
+    };
+
+    explicit HubLabels(const Graph& graph);
+
+    // Восстановление по ранее посчитанным меткам
+    HubLabels(const Graph& graph, Labels out_labels, Labels in_labels);
+
+    std::optional<Weight> GetDistance(VertexId from, VertexId to) const;
+
+    const Labels& GetOutLabels() const;
+    const Labels& GetInLabels() const;
+
+private:
+    struct QueueEntry {
+        Weight weight;
+        VertexId vertex;
+
+        bool operator>(const QueueEntry& other) const {
+            return weight > other.weight;
+        }
+    };
+
+    static constexpr Weight ZERO_WEIGHT{};
+
+    // Поиск из хаба по прямым (is_reverse == false) или обратным рёбрам,
+    // дописывает хаб в метки вершин, до которых имеющиеся метки не дают пути
+    void RunPrunedSearch(VertexId hub_vertex, CompactId hub, bool is_reverse,
+                         std::vector<std::vector<LabelEntry>>& hub_labels,
+                         std::vector<std::vector<LabelEntry>>& target_labels);
+
+    static Labels Flatten(std::vector<std::vector<LabelEntry>>& labels);
+
+    const Graph& graph_;
+    Labels out_labels_;
+    Labels in_labels_;
+
+    // Рабочие данные построения
+    std::vector<CompactId> reverse_offsets_;
+    std::vector<CompactId> reverse_sources_;
+    std::vector<Weight> reverse_weights_;
+    std::vector<Weight> hub_weights_;
+    std::vector<Weight> weights_;
+    std::vector<bool> is_reached_;
+    std::vector<VertexId> reached_;
+};
+
+template <typename Weight>
+HubLabels<Weight>::HubLabels(const Graph& graph)
+    : graph_(graph)
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    if (vertex_count > std::numeric_limits<CompactId>::max()) {
+        throw std::length_error("Too many vertices for hub labels");
+    }
+
+    std::vector<size_t> degrees(vertex_count, 0);
+    reverse_offsets_.assign(vertex_count + 1, 0);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        if (graph.IsEdgeRemoved(edge_id)) {
+            continue;
+        }
+        ++degrees[edge.from];
+        ++degrees[edge.to];
+        ++reverse_offsets_[edge.to + 1];
+    }
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        reverse_offsets_[vertex + 1] += reverse_offsets_[vertex];
+    }
+    reverse_sources_.resize(reverse_offsets_.back());
+    reverse_weights_.resize(reverse_offsets_.back());
+    std::vector<CompactId> positions(reverse_offsets_.begin(), std::prev(reverse_offsets_.end()));
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.IsEdgeRemoved(edge_id)) {
+            continue;
+        }
+        const auto& edge = graph.GetEdge(edge_id);
+        const CompactId position = positions[edge.to]++;
+        reverse_sources_[position] = static_cast<CompactId>(edge.from);
+        reverse_weights_[position] = edge.weight;
+    }
+
+    std::vector<VertexId> order(vertex_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&degrees](VertexId lhs, VertexId rhs) {
+        return degrees[lhs] > degrees[rhs];
+    });
+
+    hub_weights_.assign(vertex_count, InfiniteWeight<Weight>());
+    weights_.assign(vertex_count, InfiniteWeight<Weight>());
+    is_reached_.assign(vertex_count, false);
+
+    std::vector<std::vector<LabelEntry>> out_labels(vertex_count);
+    std::vector<std::vector<LabelEntry>> in_labels(vertex_count);
+    for (CompactId hub = 0; hub < vertex_count; ++hub) {
+        RunPrunedSearch(order[hub], hub, false, out_labels, in_labels);
+        RunPrunedSearch(order[hub], hub, true, in_labels, out_labels);
+    }
+
+    out_labels_ = Flatten(out_labels);
+    in_labels_ = Flatten(in_labels);
+
+    reverse_offsets_.clear();
+    reverse_sources_.clear();
+    reverse_weights_.clear();
+    hub_weights_.clear();
+    weights_.clear();
+    is_reached_.clear();
+    reached_.clear();
+}
+
+template <typename Weight>
+HubLabels<Weight>::HubLabels(const Graph& graph, Labels out_labels, Labels in_labels)
+    : graph_(graph)
+    , out_labels_(std::move(out_labels))
+    , in_labels_(std::move(in_labels))
+{
+    const size_t offsets_size = graph.GetVertexCount() + 1;
+    if (out_labels_.offsets.size() != offsets_size || in_labels_.offsets.size() != offsets_size
+        || out_labels_.offsets.back() != out_labels_.entries.size()
+        || in_labels_.offsets.back() != in_labels_.entries.size()) {
+        throw std::invalid_argument("Hub labels do not match the graph");
+    }
+}
+
+template <typename Weight>
+void HubLabels<Weight>::RunPrunedSearch(VertexId hub_vertex, CompactId hub, bool is_reverse,
+                                        std::vector<std::vector<LabelEntry>>& hub_labels,
+                                        std::vector<std::vector<LabelEntry>>& target_labels) {
+    // Прямой поиск: вес d(hub, v) сравнивается с d(hub, h) + d(h, v) по
+    // исходящей метке хаба и входящей метке v; обратный - симметрично
+    for (const auto& entry : hub_labels[hub_vertex]) {
+        hub_weights_[entry.hub] = entry.weight;
+    }
+
+    std::vector<QueueEntry> heap{{ZERO_WEIGHT, hub_vertex}};
+    weights_[hub_vertex] = ZERO_WEIGHT;
+    is_reached_[hub_vertex] = true;
+    reached_.push_back(hub_vertex);
+
+    const auto relax = [&](VertexId vertex, Weight weight) {
+        if (!is_reached_[vertex]) {
+            is_reached_[vertex] = true;
+            reached_.push_back(vertex);
+        } else if (!(weight < weights_[vertex])) {
+            return;
+        }
+        weights_[vertex] = weight;
+        heap.push_back({weight, vertex});
+        std::push_heap(heap.begin(), heap.end(), std::greater<QueueEntry>{});
+    };
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<QueueEntry>{});
+        const QueueEntry entry = heap.back();
+        heap.pop_back();
+        if (weights_[entry.vertex] < entry.weight) {
+            continue;
+        }
+
+        bool is_covered = false;
+        for (const auto& label_entry : target_labels[entry.vertex]) {
+            if (hub_weights_[label_entry.hub] != InfiniteWeight<Weight>()
+                && !(entry.weight < hub_weights_[label_entry.hub] + label_entry.weight)) {
+                is_covered = true;
+                break;
+            }
+        }
+        if (is_covered) {
+            continue;
+        }
+        target_labels[entry.vertex].push_back({hub, entry.weight});
+
+        if (is_reverse) {
+            for (CompactId position = reverse_offsets_[entry.vertex];
+                 position < reverse_offsets_[entry.vertex + 1]; ++position) {
+                relax(reverse_sources_[position], entry.weight + reverse_weights_[position]);
+            }
+        } else {
+            graph_.ForEachOutgoingEdge(entry.vertex, [&](EdgeId, VertexId edge_to,
+                                                         const Weight& edge_weight) {
+                relax(edge_to, entry.weight + edge_weight);
+            });
+        }
+    }
+
+    for (const VertexId vertex : reached_) {
+        weights_[vertex] = InfiniteWeight<Weight>();
+        is_reached_[vertex] = false;
+    }
+    reached_.clear();
+    for (const auto& entry : hub_labels[hub_vertex]) {
+        hub_weights_[entry.hub] = InfiniteWeight<Weight>();
+    }
+}
+
+template <typename Weight>
+typename HubLabels<Weight>::Labels HubLabels<Weight>::Flatten(std::vector<std::vector<LabelEntry>>& labels) {
+    Labels result;
+    result.offsets.reserve(labels.size() + 1);
+    result.offsets.push_back(0);
+    for (auto& label : labels) {
+        result.entries.insert(result.entries.end(), label.begin(), label.end());
+        result.offsets.push_back(static_cast<CompactId>(result.entries.size()));
+        std::vector<LabelEntry>().swap(label);
+    }
+    return result;
+}
+
+template <typename Weight>
+std::optional<Weight> HubLabels<Weight>::GetDistance(VertexId from, VertexId to) const {
+    if (from + 1 >= out_labels_.offsets.size() || to + 1 >= in_labels_.offsets.size()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    const LabelEntry* out_it = out_labels_.entries.data() + out_labels_.offsets[from];
+    const LabelEntry* out_end = out_labels_.entries.data() + out_labels_.offsets[from + 1];
+    const LabelEntry* in_it = in_labels_.entries.data() + in_labels_.offsets[to];
+    const LabelEntry* in_end = in_labels_.entries.data() + in_labels_.offsets[to + 1];
+
+    std::optional<Weight> result;
+    while (out_it != out_end && in_it != in_end) {
+        if (out_it->hub < in_it->hub) {
+            ++out_it;
+        } else if (in_it->hub < out_it->hub) {
+            ++in_it;
+        } else {
+            const Weight weight = out_it->weight + in_it->weight;
+            if (!result || weight < *result) {
+                result = weight;
+            }
+            ++out_it;
+            ++in_it;
+        }
+    }
+    return result;
+}
+
+template <typename Weight>
+const typename HubLabels<Weight>::Labels& HubLabels<Weight>::GetOutLabels() const {
+    return out_labels_;
+}
+
+template <typename Weight>
+const typename HubLabels<Weight>::Labels& HubLabels<Weight>::GetInLabels() const {
+    return in_labels_;
+}
+
+}  // namespace graph
@@ -36,6 +36,41 @@ domain::Bus parseBus(const json::Dict &_data)
     {
         new_bus.route_.emplace_back(stop.AsString());
     }
+
+    // Отправления списком и/или с интервалом от first_departure до last_departure
+    if (_data.count("departures") != 0U)
+    {
+        for (const auto &departure : _data.at("departures").AsArray())
+        {
+            new_bus.departures_.push_back(departure.AsDouble());
+        }
+    }
+    if (_data.count("timetable") != 0U)
+    {
+        // Больше рейсов - почти наверняка ошибка в интервале
+        static const double max_trip_count = 10000.0;
+
+        const auto &timetable = _data.at("timetable").AsDict();
+        const double first_departure = timetable.at("first_departure").AsDouble();
+        const double last_departure = timetable.at("last_departure").AsDouble();
+        const double interval = timetable.at("interval").AsDouble();
+        if (interval <= 0.0)
+        {
+            throw std::invalid_argument("Timetable interval should be positive");
+        }
+        if ((last_departure - first_departure) / interval >= max_trip_count)
+        {
+            throw std::invalid_argument("Timetable has too many departures");
+        }
+        // Отправление считается от первого, а не прибавлением интервала к
+        // предыдущему: так погрешность не накапливается
+        for (size_t trip = 0; first_departure + trip * interval <= last_departure; ++trip)
+        {
+            new_bus.departures_.push_back(first_departure + trip * interval);
+        }
+    }
+    std::sort(new_bus.departures_.begin(), new_bus.departures_.end());
+
     return new_bus;
 }
 
@@ -55,6 +90,58 @@ std::pair<domain::Stop, Distances> parseStop(const json::Dict &_data)
     return {std::move(new_stop), distances};
 }
 
+std::vector<std::string_view> parseStopNames(const json::Array &_data)
+{
+    std::vector<std::string_view> names;
+    names.reserve(_data.size());
+    for (const auto &name : _data)
+    {
+        names.emplace_back(name.AsString());
+    }
+    return names;
+}
+
+TransportRouter::RouteExclusions parseRouteExclusions(const json::Dict &_data)
+{
+    TransportRouter::RouteExclusions exclusions;
+    if (_data.count("stops") != 0U)
+    {
+        exclusions.stops = parseStopNames(_data.at("stops").AsArray());
+    }
+    if (_data.count("buses") != 0U)
+    {
+        for (const auto &name : _data.at("buses").AsArray())
+        {
+            exclusions.buses.emplace_back(name.AsString());
+        }
+    }
+    if (_data.count("segments") != 0U)
+    {
+        for (const auto &segment : _data.at("segments").AsArray())
+        {
+            const auto &dict = segment.AsDict();
+            exclusions.segments.push_back({dict.count("bus") != 0U ? dict.at("bus").AsString() : "",
+                                           dict.at("from").AsString(),
+                                           dict.at("to").AsString()});
+        }
+    }
+    return exclusions;
+}
+
+TransportRouter::RouteProfile parseRouteProfile(const json::Dict &_data)
+{
+    TransportRouter::RouteProfile profile;
+    if (_data.count("bus_wait_time") != 0U)
+    {
+        profile.wait_time = _data.at("bus_wait_time").AsDouble();
+    }
+    if (_data.count("bus_velocity") != 0U)
+    {
+        profile.velocity = _data.at("bus_velocity").AsDouble();
+    }
+    return profile;
+}
+
 void JsonReader::parseBaseRequests(const json::Document &_doc)
 {
     if (!_doc.GetRoot().IsDict())
@@ -128,15 +215,70 @@ std::vector<TypeRequest> JsonReader::parseStatRequests(const json::Document &_do
         }
 
         if (query.AsDict().at("type").AsString() == "Route")
+        {
+            const auto &dict = query.AsDict();
+            TypeRequest request{static_cast<uint32_t>(dict.at("id").AsInt()),
+                                TypeRequest::ROUTE,
+                                "",
+                                dict.at("from").AsString(),
+                                dict.at("to").AsString()};
+            if (dict.count("exclude") != 0U)
+            {
+                request.exclusions = parseRouteExclusions(dict.at("exclude").AsDict());
+            }
+            if (dict.count("profile") != 0U)
+            {
+                request.profile = parseRouteProfile(dict.at("profile").AsDict());
+            }
+            if (dict.count("departure_time") != 0U)
+            {
+                if (dict.count("exclude") != 0U || dict.count("profile") != 0U)
+                {
+                    request.error_message = "Timetable routes take no exclusions or profile";
+                }
+                request.departure_time = dict.at("departure_time").AsDouble();
+            }
+            queries.push_back(std::move(request));
+            continue;
+        }
+
+        if (query.AsDict().at("type").AsString() == "TravelTime")
         {
             queries.emplace_back(TypeRequest{static_cast<uint32_t>(query.AsDict().at("id").AsInt()),
-                                             TypeRequest::ROUTE,
+                                             TypeRequest::TRAVEL_TIME,
                                              "",
                                              query.AsDict().at("from").AsString(),
                                              query.AsDict().at("to").AsString(),
                                  });
             continue;
         }
+
+        if (query.AsDict().at("type").AsString() == "Isochrone")
+        {
+            const auto &dict = query.AsDict();
+            TypeRequest request{static_cast<uint32_t>(dict.at("id").AsInt()),
+                                TypeRequest::ISOCHRONE,
+                                "",
+                                dict.at("from").AsString(),
+                                ""};
+            request.max_time = dict.at("max_time").AsDouble();
+            request.with_map = dict.count("with_map") != 0U && dict.at("with_map").AsBool();
+            queries.push_back(std::move(request));
+            continue;
+        }
+
+        if (query.AsDict().at("type").AsString() == "RouteMatrix")
+        {
+            const auto &dict = query.AsDict();
+            TypeRequest request{static_cast<uint32_t>(dict.at("id").AsInt()),
+                                TypeRequest::ROUTE_MATRIX,
+                                "","",""};
+            request.origins = parseStopNames(dict.at("origins").AsArray());
+            request.destinations = parseStopNames(dict.at("destinations").AsArray());
+            request.with_items = dict.count("with_items") != 0U && dict.at("with_items").AsBool();
+            queries.push_back(std::move(request));
+            continue;
+        }
     }
 
     return queries;
@@ -228,9 +370,202 @@ void JsonReader::parseRoutingSettings(const json::Document &_doc)
     router_.setWaitTime(settings.at("bus_wait_time").AsInt())
             .setVelocity(settings.at("bus_velocity").AsInt());
 
+    if (settings.count("router_mode") != 0U)
+    {
+        const auto &mode = settings.at("router_mode").AsString();
+        if (mode == "precompute")
+        {
+            router_.setRouterMode(TransportRouter::RouterMode::PRECOMPUTE);
+        }
+        else if (mode == "on_demand")
+        {
+            router_.setRouterMode(TransportRouter::RouterMode::ON_DEMAND);
+        }
+        else if (mode == "raptor")
+        {
+            router_.setRouterMode(TransportRouter::RouterMode::RAPTOR);
+        }
+        else if (mode == "contraction_hierarchy")
+        {
+            router_.setRouterMode(TransportRouter::RouterMode::CONTRACTION_HIERARCHY);
+        }
+        else if (mode == "a_star")
+        {
+            router_.setRouterMode(TransportRouter::RouterMode::A_STAR);
+        }
+        else if (mode == "alt")
+        {
+            router_.setRouterMode(TransportRouter::RouterMode::ALT);
+        }
+        else if (mode == "hub_labels")
+        {
+            router_.setRouterMode(TransportRouter::RouterMode::HUB_LABELS);
+        }
+        else if (mode == "lazy")
+        {
+            router_.setRouterMode(TransportRouter::RouterMode::LAZY);
+        }
+        else if (mode == "overlay")
+        {
+            router_.setRouterMode(TransportRouter::RouterMode::OVERLAY);
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown router_mode");
+        }
+    }
+
+    if (settings.count("graph_model") != 0U)
+    {
+        const auto &model = settings.at("graph_model").AsString();
+        if (model == "stop_pairs")
+        {
+            router_.setGraphModel(TransportRouter::GraphModel::STOP_PAIRS);
+        }
+        else if (model == "merged_stops")
+        {
+            router_.setGraphModel(TransportRouter::GraphModel::MERGED_STOPS);
+        }
+        else if (model == "line")
+        {
+            router_.setGraphModel(TransportRouter::GraphModel::LINE);
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown graph_model");
+        }
+    }
+
+    if (settings.count("all_pairs_algorithm") != 0U)
+    {
+        const auto &algorithm = settings.at("all_pairs_algorithm").AsString();
+        if (algorithm == "floyd_warshall")
+        {
+            router_.setAllPairsAlgorithm(graph::AllPairsAlgorithm::FLOYD_WARSHALL);
+        }
+        else if (algorithm == "blocked_floyd_warshall")
+        {
+            router_.setAllPairsAlgorithm(graph::AllPairsAlgorithm::BLOCKED_FLOYD_WARSHALL);
+        }
+        else if (algorithm == "parallel_dijkstra")
+        {
+            router_.setAllPairsAlgorithm(graph::AllPairsAlgorithm::PARALLEL_DIJKSTRA);
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown all_pairs_algorithm");
+        }
+    }
+
+    if (settings.count("build_threads") != 0U)
+    {
+        router_.setBuildThreads(static_cast<size_t>(settings.at("build_threads").AsInt()));
+    }
+
+    if (settings.count("landmark_count") != 0U)
+    {
+        router_.setLandmarkCount(static_cast<size_t>(settings.at("landmark_count").AsInt()));
+    }
+
+    if (settings.count("row_cache_mb") != 0U)
+    {
+        router_.setRowCacheBytes(static_cast<size_t>(settings.at("row_cache_mb").AsInt()) << 20U);
+    }
+
+    if (settings.count("overlay_cell_sizes") != 0U)
+    {
+        std::vector<size_t> sizes;
+        for (const auto &size : settings.at("overlay_cell_sizes").AsArray())
+        {
+            sizes.push_back(static_cast<size_t>(size.AsInt()));
+        }
+        router_.setOverlayCellSizes(std::move(sizes));
+    }
+
+    if (settings.count("table_weight") != 0U)
+    {
+        const auto &format = settings.at("table_weight").AsString();
+        if (format == "double")
+        {
+            router_.setTableWeightFormat(TransportRouter::TableWeightFormat::DOUBLE);
+        }
+        else if (format == "fixed_point")
+        {
+            router_.setTableWeightFormat(TransportRouter::TableWeightFormat::FIXED_POINT);
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown table_weight");
+        }
+    }
+
     router_.setInitSetting(true);
 }
 
+void JsonReader::parseBaseUpdates(const json::Document &_doc)
+{
+    if (!_doc.GetRoot().IsDict())
+    {
+        throw std::invalid_argument("Incorrect JSON");
+    }
+
+    const auto& query_map = _doc.GetRoot().AsDict();
+    if (query_map.count("base_updates") == 0U)
+    {
+        return;
+    }
+
+    for (const auto &query : query_map.at("base_updates").AsArray())
+    {
+        if (query.AsDict().at("type").AsString() != "Bus")
+        {
+            throw std::invalid_argument("Only buses can be updated in a ready base");
+        }
+
+        auto new_bus = parseBus(query.AsDict());
+        for (const auto stop : new_bus.route_)
+        {
+            if (catalogue_.findStop(stop) == nullptr)
+            {
+                throw std::invalid_argument("Unknown stop in a bus update");
+            }
+        }
+        catalogue_.removeBus(new_bus.name_);
+        catalogue_.addBus(std::move(new_bus));
+    }
+
+    router_.updateBuses(catalogue_, catalogue_.getSortedBuses());
+}
+
+void JsonReader::parseRoutingSettingsUpdate(const json::Document &_doc)
+{
+    if (!_doc.GetRoot().IsDict())
+    {
+        throw std::invalid_argument("Incorrect JSON");
+    }
+
+    if (_doc.GetRoot().AsDict().count("routing_settings") == 0U)
+    {
+        return;
+    }
+
+    const auto& settings = _doc.GetRoot().AsDict().at("routing_settings").AsDict();
+    std::optional<int> wait_time;
+    if (settings.count("bus_wait_time") != 0U)
+    {
+        wait_time = settings.at("bus_wait_time").AsInt();
+    }
+    std::optional<int> velocity;
+    if (settings.count("bus_velocity") != 0U)
+    {
+        velocity = settings.at("bus_velocity").AsInt();
+    }
+    const bool allow_rebuild = settings.count("allow_rebuild") != 0U &&
+            settings.at("allow_rebuild").AsBool();
+
+    router_.updateSettings(catalogue_, wait_time, velocity, allow_rebuild);
+}
+
 std::optional<std::string> JsonReader::parseSerializationSettings(const json::Document &_doc)
 {
     if (!_doc.GetRoot().IsDict())
@@ -328,6 +663,43 @@ json::Node JsonReader::writeMap(const svg::Document &_doc, uint32_t _id)
     return builder.Build();
 }
 
+json::Node writeRouteItems(const std::vector<TransportRouter::RouteItem> &_items)
+{
+    using namespace std::literals::string_literals;
+
+    json::Builder builder;
+
+    builder.StartArray();
+    for (const auto& route_item : _items)
+    {
+        if (const auto *wait_info =
+                std::get_if<domain::WaitInfo>(&route_item))
+        {
+            builder.StartDict().
+                    Key("type"s).Value("Wait"s).
+                    Key("stop_name"s).Value(wait_info->name.data()).
+                    Key("time").Value(wait_info->time).
+                    EndDict();
+            continue;
+        }
+
+        if (const auto *route_info =
+                std::get_if<domain::BusRouteInfo>(&route_item))
+        {
+            builder.StartDict().
+                    Key("type"s).Value("Bus"s).
+                    Key("bus"s).Value(route_info->name.data()).
+                    Key("span_count"s).Value(route_info->span_count).
+                    Key("time"s).Value(route_info->time).
+                    EndDict();
+            continue;
+        }
+    }
+    builder.EndArray();
+
+    return builder.Build();
+}
+
 json::Node JsonReader::writeRoute(const RouteStat &_statisics, uint32_t _id)
 {
     using namespace std::literals::string_literals;
@@ -340,40 +712,130 @@ json::Node JsonReader::writeRoute(const RouteStat &_statisics, uint32_t _id)
     {
         builder.Key("request_id"s).Value(static_cast<int>(_id)).
                 Key("total_time"s).Value(_statisics->first).
-                Key("items"s).StartArray();
+                Key("items"s).Value(writeRouteItems(_statisics->second));
+    }
+    else
+    {
+        dist.Key("request_id"s).Value(static_cast<int>(_id)).
+                Key("error_message"s).Value("not found"s);
+    }
+
+    dist.EndDict();
+
+    return builder.Build();
+}
+
+json::Node JsonReader::writeTravelTime(const std::optional<double> &_time, uint32_t _id)
+{
+    using namespace std::literals::string_literals;
 
-        for (const auto& route_item : _statisics->second)
+    json::Builder builder;
+
+    auto dist = builder.StartDict();
+
+    dist.Key("request_id"s).Value(static_cast<int>(_id));
+    if (_time.has_value())
+    {
+        dist.Key("total_time"s).Value(*_time);
+    }
+    else
+    {
+        dist.Key("error_message"s).Value("not found"s);
+    }
+
+    dist.EndDict();
+
+    return builder.Build();
+}
+
+json::Node JsonReader::writeError(std::string_view _message, uint32_t _id)
+{
+    using namespace std::literals::string_literals;
+
+    json::Builder builder;
+
+    auto dist = builder.StartDict();
+
+    dist.Key("request_id"s).Value(static_cast<int>(_id)).
+            Key("error_message"s).Value(std::string(_message));
+
+    dist.EndDict();
+
+    return builder.Build();
+}
+
+json::Node JsonReader::writeIsochrone(const TransportRouter::Isochrone &_stops,
+                                      const std::optional<svg::Document> &_map, uint32_t _id)
+{
+    using namespace std::literals::string_literals;
+
+    json::Builder builder;
+
+    auto dist = builder.StartDict();
+
+    dist.Key("request_id"s).Value(static_cast<int>(_id)).
+            Key("stops"s).StartArray();
+    for (const auto &[name, time] : _stops)
+    {
+        builder.StartDict().
+                Key("stop_name"s).Value(std::string(name)).
+                Key("time"s).Value(time).
+                EndDict();
+    }
+    builder.EndArray();
+
+    if (_map.has_value())
+    {
+        std::stringstream doc_stream;
+        _map->Render(doc_stream);
+        builder.Key("map"s).Value(doc_stream.str());
+    }
+
+    dist.EndDict();
+
+    return builder.Build();
+}
+
+json::Node JsonReader::writeRouteMatrix(const TransportRouter::RouteMatrix &_matrix,
+                                        size_t _row_count, size_t _column_count,
+                                        bool _with_items, uint32_t _id)
+{
+    using namespace std::literals::string_literals;
+
+    json::Builder builder;
+
+    auto dist = builder.StartDict();
+
+    // Ячейка без маршрута - null
+    dist.Key("request_id"s).Value(static_cast<int>(_id)).
+            Key("total_times"s).StartArray();
+    for (size_t row = 0; row < _row_count; ++row)
+    {
+        auto times = builder.StartArray();
+        for (size_t column = 0; column < _column_count; ++column)
         {
-            if (const auto *wait_info =
-                    std::get_if<domain::WaitInfo>(&route_item))
-            {
-                builder.StartDict().
-                        Key("type"s).Value("Wait"s).
-                        Key("stop_name"s).Value(wait_info->name.data()).
-                        Key("time").Value(wait_info->time).
-                        EndDict();
-                continue;
-            }
+            const auto &route = _matrix[row * _column_count + column];
+            times.Value(route.has_value() ? json::Node(route->first) : json::Node(nullptr));
+        }
+        times.EndArray();
+    }
+    builder.EndArray();
 
-            if (const auto *route_info =
-                    std::get_if<domain::BusRouteInfo>(&route_item))
+    if (_with_items)
+    {
+        builder.Key("items"s).StartArray();
+        for (size_t row = 0; row < _row_count; ++row)
+        {
+            auto items = builder.StartArray();
+            for (size_t column = 0; column < _column_count; ++column)
             {
-                builder.StartDict().
-                        Key("type"s).Value("Bus"s).
-                        Key("bus"s).Value(route_info->name.data()).
-                        Key("span_count"s).Value(route_info->span_count).
-                        Key("time"s).Value(route_info->time).
-                        EndDict();
-                continue;
+                const auto &route = _matrix[row * _column_count + column];
+                items.Value(route.has_value() ? writeRouteItems(route->second) : json::Node(nullptr));
             }
+            items.EndArray();
         }
         builder.EndArray();
     }
-    else
-    {
-        dist.Key("request_id"s).Value(static_cast<int>(_id)).
-                Key("error_message"s).Value("not found"s);
-    }
 
     dist.EndDict();
 
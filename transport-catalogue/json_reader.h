@@ -27,6 +27,9 @@ struct TypeRequest
         STOP,
         MAP,
         ROUTE,
+        TRAVEL_TIME,
+        ROUTE_MATRIX,
+        ISOCHRONE,
     };
 
     uint32_t id;
@@ -34,6 +37,20 @@ struct TypeRequest
     std::string_view name;
     std::string_view from;
     std::string_view to;
+    // Непустое - запрос задан неверно, ответом будет эта ошибка
+    std::string_view error_message = {};
+    // Только для ROUTE
+    TransportRouter::RouteExclusions exclusions = {};
+    TransportRouter::RouteProfile profile = {};
+    // Маршрут по расписаниям с отправлением не раньше departure_time
+    std::optional<double> departure_time = {};
+    // Только для ROUTE_MATRIX
+    std::vector<std::string_view> origins = {};
+    std::vector<std::string_view> destinations = {};
+    bool with_items = false;
+    // Только для ISOCHRONE, начало - from
+    double max_time = 0.0;
+    bool with_map = false;
 };
 
 class JsonReader
@@ -60,6 +77,15 @@ public:
 
     void parseRoutingSettings(const json::Document &_doc);
 
+    // Автобусы из base_updates запросов к готовой базе: автобус с тем же
+    // именем заменяется, новый добавляется. Маршрутизатор обновляется
+    // без пересборки базы
+    void parseBaseUpdates(const json::Document &_doc);
+
+    // bus_wait_time и bus_velocity из запросов к готовой базе, если заданы;
+    // allow_rebuild разрешает строить заново предподсчёт, который от них зависит
+    void parseRoutingSettingsUpdate(const json::Document &_doc);
+
     std::optional<std::string> parseSerializationSettings(const json::Document &_doc);
 
     static json::Node writeStopStat(const domain::StopStat &_statisics, uint32_t _id);
@@ -70,6 +96,19 @@ public:
 
     static json::Node writeRoute(const RouteStat &_statisics, uint32_t _id);
 
+    static json::Node writeTravelTime(const std::optional<double> &_time, uint32_t _id);
+
+    // Ответ на запрос, который нельзя выполнить: error_message с _message
+    static json::Node writeError(std::string_view _message, uint32_t _id);
+
+    static json::Node writeIsochrone(const TransportRouter::Isochrone &_stops,
+                                     const std::optional<svg::Document> &_map, uint32_t _id);
+
+    // _matrix - _row_count строк по _column_count маршрутов
+    static json::Node writeRouteMatrix(const TransportRouter::RouteMatrix &_matrix,
+                                       size_t _row_count, size_t _column_count,
+                                       bool _with_items, uint32_t _id);
+
 private:
     TransportCatalogue &catalogue_;
     renderer::MapRenderer &render_;
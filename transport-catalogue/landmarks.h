@@ -0,0 +1,241 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Ориентиры для A* (ALT: A*, Landmarks, Triangle inequality). Для каждого
+// ориентира L хранятся веса путей L -> v и v -> L до всех вершин, по
+// неравенству треугольника они дают нижнюю оценку веса пути v -> t:
+//   d(v, t) >= d(v, L) - d(t, L),  d(v, t) >= d(L, t) - d(L, v).
+// Максимум согласованных оценок тоже согласован.
+template <typename Weight>
+class Landmarks {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    // Ориентиры выбираются по очереди: следующий - вершина, наиболее
+    // удалённая от уже выбранных
+    Landmarks(const Graph& graph, size_t landmark_count);
+
+    // Восстановление по ранее посчитанным таблицам
+    Landmarks(const Graph& graph, std::vector<VertexId> landmarks,
+              std::vector<Weight> distances_from, std::vector<Weight> distances_to);
+
+    // Нижняя оценка веса пути от vertex до to
+    Weight GetLowerBound(VertexId vertex, VertexId to) const;
+
+    const std::vector<VertexId>& GetLandmarks() const;
+    // Веса путей от ориентиров и до них, по строке на ориентир
+    const std::vector<Weight>& GetDistancesFrom() const;
+    const std::vector<Weight>& GetDistancesTo() const;
+
+private:
+    struct QueueEntry {
+        Weight weight;
+        VertexId vertex;
+
+        bool operator>(const QueueEntry& other) const {
+            return weight > other.weight;
+        }
+    };
+
+    static constexpr Weight ZERO_WEIGHT{};
+
+    void BuildReverseGraph();
+    // Веса путей от source (или до source при is_reverse) до всех вершин
+    void ComputeDistances(VertexId source, bool is_reverse, Weight* distances) const;
+
+    const Graph& graph_;
+    std::vector<VertexId> landmarks_;
+    std::vector<Weight> distances_from_;
+    std::vector<Weight> distances_to_;
+
+    // Входящие рёбра в формате CSR для обратного поиска
+    std::vector<CompactId> reverse_offsets_;
+    std::vector<CompactId> reverse_sources_;
+    std::vector<Weight> reverse_weights_;
+};
+
+template <typename Weight>
+Landmarks<Weight>::Landmarks(const Graph& graph, size_t landmark_count)
+    : graph_(graph)
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    landmark_count = std::min(landmark_count, vertex_count);
+    if (landmark_count == 0) {
+        return;
+    }
+
+    BuildReverseGraph();
+    distances_from_.resize(landmark_count * vertex_count);
+    distances_to_.resize(landmark_count * vertex_count);
+
+    // Удалённость вершины от выбранных ориентиров - минимум по ним суммы
+    // весов путей туда и обратно; недостижимые вершины удалены бесконечно
+    std::vector<Weight> remoteness(vertex_count, InfiniteWeight<Weight>());
+
+    // Первый ориентир - самая далёкая от вершины 0 вершина
+    std::vector<Weight> initial(vertex_count);
+    ComputeDistances(0, false, initial.data());
+    VertexId next = 0;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        if (initial[vertex] != InfiniteWeight<Weight>() && initial[next] < initial[vertex]) {
+            next = vertex;
+        }
+    }
+
+    for (size_t index = 0; index < landmark_count; ++index) {
+        landmarks_.push_back(next);
+        Weight* from_row = distances_from_.data() + index * vertex_count;
+        Weight* to_row = distances_to_.data() + index * vertex_count;
+        ComputeDistances(next, false, from_row);
+        ComputeDistances(next, true, to_row);
+
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            if (from_row[vertex] != InfiniteWeight<Weight>()
+                && to_row[vertex] != InfiniteWeight<Weight>()) {
+                remoteness[vertex] = std::min(remoteness[vertex], from_row[vertex] + to_row[vertex]);
+            }
+        }
+        remoteness[next] = ZERO_WEIGHT;
+
+        next = static_cast<VertexId>(
+            std::max_element(remoteness.begin(), remoteness.end()) - remoteness.begin());
+    }
+
+    reverse_offsets_.clear();
+    reverse_sources_.clear();
+    reverse_weights_.clear();
+}
+
+template <typename Weight>
+Landmarks<Weight>::Landmarks(const Graph& graph, std::vector<VertexId> landmarks,
+                             std::vector<Weight> distances_from, std::vector<Weight> distances_to)
+    : graph_(graph)
+    , landmarks_(std::move(landmarks))
+    , distances_from_(std::move(distances_from))
+    , distances_to_(std::move(distances_to))
+{
+    const size_t table_size = landmarks_.size() * graph.GetVertexCount();
+    if (distances_from_.size() != table_size || distances_to_.size() != table_size) {
+        throw std::invalid_argument("Landmark distances do not match the graph");
+    }
+}
+
+template <typename Weight>
+void Landmarks<Weight>::BuildReverseGraph() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    reverse_offsets_.assign(vertex_count + 1, 0);
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        if (!graph_.IsEdgeRemoved(edge_id)) {
+            ++reverse_offsets_[graph_.GetEdge(edge_id).to + 1];
+        }
+    }
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        reverse_offsets_[vertex + 1] += reverse_offsets_[vertex];
+    }
+
+    reverse_sources_.resize(reverse_offsets_.back());
+    reverse_weights_.resize(reverse_offsets_.back());
+    std::vector<CompactId> positions(reverse_offsets_.begin(), std::prev(reverse_offsets_.end()));
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        if (graph_.IsEdgeRemoved(edge_id)) {
+            continue;
+        }
+        const auto& edge = graph_.GetEdge(edge_id);
+        const CompactId position = positions[edge.to]++;
+        reverse_sources_[position] = static_cast<CompactId>(edge.from);
+        reverse_weights_[position] = edge.weight;
+    }
+}
+
+template <typename Weight>
+void Landmarks<Weight>::ComputeDistances(VertexId source, bool is_reverse, Weight* distances) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    std::fill(distances, distances + vertex_count, InfiniteWeight<Weight>());
+
+    std::vector<QueueEntry> heap{{ZERO_WEIGHT, source}};
+    distances[source] = ZERO_WEIGHT;
+
+    const auto relax = [&](VertexId vertex, Weight weight) {
+        if (weight < distances[vertex]) {
+            distances[vertex] = weight;
+            heap.push_back({weight, vertex});
+            std::push_heap(heap.begin(), heap.end(), std::greater<QueueEntry>{});
+        }
+    };
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<QueueEntry>{});
+        const QueueEntry entry = heap.back();
+        heap.pop_back();
+        if (distances[entry.vertex] < entry.weight) {
+            continue;
+        }
+
+        if (is_reverse) {
+            for (CompactId position = reverse_offsets_[entry.vertex];
+                 position < reverse_offsets_[entry.vertex + 1]; ++position) {
+                relax(reverse_sources_[position], entry.weight + reverse_weights_[position]);
+            }
+        } else {
+            graph_.ForEachOutgoingEdge(entry.vertex, [&](EdgeId, VertexId edge_to,
+                                                         const Weight& edge_weight) {
+                relax(edge_to, entry.weight + edge_weight);
+            });
+        }
+    }
+}
+
+template <typename Weight>
+Weight Landmarks<Weight>::GetLowerBound(VertexId vertex, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    Weight bound = ZERO_WEIGHT;
+    for (size_t index = 0; index < landmarks_.size(); ++index) {
+        const Weight* from_row = distances_from_.data() + index * vertex_count;
+        const Weight* to_row = distances_to_.data() + index * vertex_count;
+
+        // Слагаемые с бесконечными весами оценки не дают
+        if (to_row[vertex] != InfiniteWeight<Weight>() && to_row[to] != InfiniteWeight<Weight>()
+            && bound < to_row[vertex] - to_row[to]) {
+            bound = to_row[vertex] - to_row[to];
+        }
+        if (from_row[to] != InfiniteWeight<Weight>() && from_row[vertex] != InfiniteWeight<Weight>()
+            && bound < from_row[to] - from_row[vertex]) {
+            bound = from_row[to] - from_row[vertex];
+        }
+    }
+    return bound;
+}
+
+template <typename Weight>
+const std::vector<VertexId>& Landmarks<Weight>::GetLandmarks() const {
+    return landmarks_;
+}
+
+template <typename Weight>
+const std::vector<Weight>& Landmarks<Weight>::GetDistancesFrom() const {
+    return distances_from_;
+}
+
+template <typename Weight>
+const std::vector<Weight>& Landmarks<Weight>::GetDistancesTo() const {
+    return distances_to_;
+}
+
+}  // namespace graph
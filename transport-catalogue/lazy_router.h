@@ -0,0 +1,210 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace graph {
+
+// Строки таблицы маршрутов по требованию. При первом запросе из вершины
+// поиск Дейкстры считает веса и предыдущие рёбра до всех вершин, строка
+// сохраняется в кэше и отвечает на следующие запросы из этой вершины.
+// Кэш ограничен по памяти, при переполнении вытесняется строка, к которой
+// дольше всего не обращались.
+template <typename Weight>
+class LazyRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    LazyRouter(const Graph& graph, size_t memory_budget);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    size_t GetCachedRowCount() const;
+
+    // Вытесняет строки, которые изменение графа могло испортить: их маршруты
+    // идут через подорожавшие или удалённые increased_edges, или одно из
+    // подешевевших или добавленных decreased_edges улучшает вес своего конца
+    void UpdateEdges(const std::vector<EdgeId>& increased_edges,
+                     const std::vector<EdgeId>& decreased_edges);
+
+private:
+    using CompactEdgeId = uint32_t;
+    static constexpr CompactEdgeId NO_EDGE = std::numeric_limits<CompactEdgeId>::max();
+    static constexpr Weight ZERO_WEIGHT{};
+
+    struct Row {
+        std::vector<Weight> weights;
+        std::vector<CompactEdgeId> prev_edges;
+        std::list<VertexId>::iterator usage_it;
+    };
+
+    struct QueueEntry {
+        Weight weight;
+        VertexId vertex;
+
+        bool operator>(const QueueEntry& other) const {
+            return weight > other.weight;
+        }
+    };
+
+    const Row& GetRow(VertexId from) const;
+    void ComputeRow(VertexId from, Row& row) const;
+
+    const Graph& graph_;
+    size_t max_row_count_ = 1;
+
+    mutable std::unordered_map<VertexId, Row> rows_;
+    // Порядок обращений: в начале - последняя использованная строка
+    mutable std::list<VertexId> usage_;
+    mutable std::vector<QueueEntry> heap_;
+};
+
+template <typename Weight>
+LazyRouter<Weight>::LazyRouter(const Graph& graph, size_t memory_budget)
+    : graph_(graph)
+{
+    if (graph.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for the row cache");
+    }
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+
+    // Одна строка хранится всегда, иначе запрос некуда посчитать
+    const size_t row_bytes = graph.GetVertexCount() * (sizeof(Weight) + sizeof(CompactEdgeId));
+    if (row_bytes > 0) {
+        max_row_count_ = std::max<size_t>(1, memory_budget / row_bytes);
+    }
+}
+
+template <typename Weight>
+void LazyRouter<Weight>::ComputeRow(VertexId from, Row& row) const {
+    row.weights.assign(graph_.GetVertexCount(), InfiniteWeight<Weight>());
+    row.prev_edges.assign(graph_.GetVertexCount(), NO_EDGE);
+
+    heap_.clear();
+    heap_.push_back({ZERO_WEIGHT, from});
+    row.weights[from] = ZERO_WEIGHT;
+
+    while (!heap_.empty()) {
+        std::pop_heap(heap_.begin(), heap_.end(), std::greater<QueueEntry>{});
+        const QueueEntry entry = heap_.back();
+        heap_.pop_back();
+        if (row.weights[entry.vertex] < entry.weight) {
+            continue;
+        }
+
+        graph_.ForEachOutgoingEdge(entry.vertex, [&](EdgeId edge_id, VertexId edge_to,
+                                                     const Weight& edge_weight) {
+            const Weight candidate_weight = entry.weight + edge_weight;
+            if (candidate_weight < row.weights[edge_to]) {
+                row.weights[edge_to] = candidate_weight;
+                row.prev_edges[edge_to] = static_cast<CompactEdgeId>(edge_id);
+                heap_.push_back({candidate_weight, edge_to});
+                std::push_heap(heap_.begin(), heap_.end(), std::greater<QueueEntry>{});
+            }
+        });
+    }
+}
+
+template <typename Weight>
+const typename LazyRouter<Weight>::Row& LazyRouter<Weight>::GetRow(VertexId from) const {
+    if (auto it = rows_.find(from); it != rows_.end()) {
+        usage_.splice(usage_.begin(), usage_, it->second.usage_it);
+        return it->second;
+    }
+
+    // Память вытесняемой строки переиспользуется для новой
+    Row row;
+    if (rows_.size() >= max_row_count_) {
+        const VertexId evicted = usage_.back();
+        usage_.pop_back();
+        auto evicted_it = rows_.find(evicted);
+        row = std::move(evicted_it->second);
+        rows_.erase(evicted_it);
+    }
+
+    ComputeRow(from, row);
+    usage_.push_front(from);
+    row.usage_it = usage_.begin();
+    return rows_.emplace(from, std::move(row)).first->second;
+}
+
+template <typename Weight>
+std::optional<typename LazyRouter<Weight>::RouteInfo>
+LazyRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    const Row& row = GetRow(from);
+    if (row.weights[to] == InfiniteWeight<Weight>()) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (CompactEdgeId edge_id = row.prev_edges[to];
+         edge_id != NO_EDGE;
+         edge_id = row.prev_edges[graph_.GetEdge(edge_id).from])
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{row.weights[to], std::move(edges)};
+}
+
+template <typename Weight>
+size_t LazyRouter<Weight>::GetCachedRowCount() const {
+    return rows_.size();
+}
+
+template <typename Weight>
+void LazyRouter<Weight>::UpdateEdges(const std::vector<EdgeId>& increased_edges,
+                                     const std::vector<EdgeId>& decreased_edges) {
+    if (graph_.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for the row cache");
+    }
+
+    const auto is_stale = [&](const Row& row) {
+        for (const EdgeId edge_id : increased_edges) {
+            if (row.prev_edges[graph_.GetEdge(edge_id).to] == edge_id) {
+                return true;
+            }
+        }
+        for (const EdgeId edge_id : decreased_edges) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (row.weights[edge.from] != InfiniteWeight<Weight>()
+                && row.weights[edge.from] + edge.weight < row.weights[edge.to]) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    for (auto it = rows_.begin(); it != rows_.end();) {
+        if (is_stale(it->second)) {
+            usage_.erase(it->second.usage_it);
+            it = rows_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+}  // namespace graph
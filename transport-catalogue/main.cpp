@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <fstream>
+#include <iostream>
 #include <sstream>
 
 #include "json_reader.h"
@@ -70,6 +71,17 @@ int main(int argc, char* argv[])
         {
             serialization::Serialization serialization(path.value());
             serialization.Deserialize(catalogue, render, router);
+            try
+            {
+                reader.parseBaseUpdates(json_input);
+                reader.parseRoutingSettingsUpdate(json_input);
+            }
+            catch (const std::invalid_argument &_error)
+            {
+                // Ошибка настройки запросов: ни один запрос не обработан
+                std::cerr << "Invalid base_updates or routing_settings: " << _error.what() << '\n';
+                return 1;
+            }
 
             handler.procRequests(json_input, ofs);
         }
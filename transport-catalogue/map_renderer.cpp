@@ -219,20 +219,9 @@ svg::Document MapRenderer::render(const TransportCatalogue &_catalogue) const
         return doc;
     }
 
-    std::deque<geo::Coordinates> geo_points;
-
     const auto stops = _catalogue.getSortedUsedStops();
 
-    for (const auto *stop: stops)
-    {
-        geo_points.push_back({ stop->latitude_, stop->longitude_ });
-    }
-
-    const renderer::SphereProjector sp(geo_points.begin(),
-                                       geo_points.end(),
-                                       this->getWidht(),
-                                       this->getHeight(),
-                                       this->getPadding());
+    const renderer::SphereProjector sp = createProjector(stops);
 
     ///отрисовка маршрутов
     {
@@ -267,6 +256,44 @@ svg::Document MapRenderer::render(const TransportCatalogue &_catalogue) const
     return doc;
 }
 
+svg::Document MapRenderer::renderIsochrone(const TransportCatalogue &_catalogue,
+                                           const std::vector<std::pair<std::string_view, double>> &_stops,
+                                           double _max_time) const
+{
+    svg::Document doc = render(_catalogue);
+    if (!this->is_init_)
+    {
+        return doc;
+    }
+
+    // Проекция та же, что у карты, чтобы круги легли на остановки
+    const renderer::SphereProjector sp = createProjector(_catalogue.getSortedUsedStops());
+    for (const auto &[name, time] : _stops)
+    {
+        const domain::Stop *stop = _catalogue.findStop(name);
+        const double time_share = _max_time > 0.0 ? std::clamp(time / _max_time, 0.0, 1.0) : 0.0;
+        doc.Add(renderCircleIsochroneStop(sp({ stop->latitude_, stop->longitude_ }), time_share));
+    }
+
+    return doc;
+}
+
+renderer::SphereProjector MapRenderer::createProjector(const std::vector<const domain::Stop *> &_stops) const
+{
+    std::deque<geo::Coordinates> geo_points;
+
+    for (const auto *stop: _stops)
+    {
+        geo_points.push_back({ stop->latitude_, stop->longitude_ });
+    }
+
+    return renderer::SphereProjector(geo_points.begin(),
+                                     geo_points.end(),
+                                     this->getWidht(),
+                                     this->getHeight(),
+                                     this->getPadding());
+}
+
 bool MapRenderer::getInitSetting() const noexcept
 {
     return is_init_;
@@ -348,6 +375,20 @@ svg::Circle MapRenderer::renderCircleStop(svg::Point pos) const
     return circle;
 }
 
+svg::Circle MapRenderer::renderCircleIsochroneStop(svg::Point pos, double time_share) const
+{
+    static const double opacity = 0.6;
+    const auto red = static_cast<uint8_t>(255.0 * time_share);
+    const auto green = static_cast<uint8_t>(255.0 * (1.0 - time_share));
+
+    svg::Circle circle;
+    circle.SetCenter(pos)
+            .SetRadius(settings_.stop_radius_ * 2.0)
+            .SetFillColor(svg::Rgba{red, green, 0, opacity})
+            .SetStrokeColor(svg::NoneColor);
+    return circle;
+}
+
 svg::Text MapRenderer::renderTextStop(svg::Point pos, std::string_view text) const
 {
     svg::Text result;
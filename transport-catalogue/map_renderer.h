@@ -137,6 +137,12 @@ public:
     void setInitSetting(bool value);
     svg::Document render(const TransportCatalogue &_catalogue) const;
 
+    // Карта с кругами достижимых остановок поверх: цвет круга меняется
+    // от зелёного у начала до красного у _max_time
+    svg::Document renderIsochrone(const TransportCatalogue &_catalogue,
+                                  const std::vector<std::pair<std::string_view, double>> &_stops,
+                                  double _max_time) const;
+
     [[nodiscard]] bool getInitSetting() const noexcept;
     [[nodiscard]] double getWidht() const noexcept;
     [[nodiscard]] double getHeight() const noexcept;
@@ -156,6 +162,8 @@ public:
 
     [[nodiscard]] svg::Text renderTextStop(svg::Point pos, std::string_view text) const;
 
+    [[nodiscard]] svg::Circle renderCircleIsochroneStop(svg::Point pos, double time_share) const;
+
     [[nodiscard]] svg::Text renderTextUnderlayerStop(svg::Point pos,
                                                      std::string_view text) const;
 
@@ -165,6 +173,8 @@ private:
     bool is_init_ = false;
     Settings settings_;
 
+    renderer::SphereProjector createProjector(const std::vector<const domain::Stop *> &_stops) const;
+
     void createRoutePolylines(svg::Document &_doc,
                               const TransportCatalogue &_catalogue,
                               const renderer::SphereProjector &_sp,
@@ -0,0 +1,979 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Многоуровневый оверлей (Customizable Route Planning). Граф один раз
+// разбивается на вложенные клетки: клетка уровня l + 1 - объединение клеток
+// уровня l. Разбиение от весов не зависит. Настройка (Customize) считает для
+// каждой клетки веса кратчайших путей внутри клетки между всеми парами её
+// граничных вершин - клики; клетки одного уровня независимы и считаются
+// параллельно, клики уровня l + 1 - поиском по кликам уровня l. Дуга, путь
+// которой проходит через другую граничную вершину, в клику не попадает:
+// её заменяют две более короткие.
+//
+// Запрос - двунаправленный Дейкстра, который в вершине идёт по клике самого
+// высокого уровня, на котором вершина лежит в другой клетке, чем начало
+// и цель, и по рёбрам, выходящим из этой клетки. Рядом с началом и целью
+// поиск идёт по исходным рёбрам. Дуги клик раскрываются в исходные рёбра поиском внутри клетки
+// по уровню ниже.
+//
+// После изменения весов рёбер достаточно повторить Customize: разбиение
+// и граничные вершины остаются прежними.
+template <typename Weight>
+class MultilevelOverlay {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    // Номера клеток вершин, по вектору на уровень, снизу вверх
+    using Partition = std::vector<std::vector<uint32_t>>;
+
+    // Положение вершины на плоскости
+    using Point = std::pair<double, double>;
+
+    // Разбиение делением пополам: клетка уровня i - не больше cell_sizes[i]
+    // вершин, размеры строго возрастают. Уровни, на которых весь граф
+    // помещается в одну клетку, не строятся. С points (по точке на вершину)
+    // кроме порядка обхода в ширину пробуются разрезы прямыми
+    MultilevelOverlay(const Graph& graph, const std::vector<size_t>& cell_sizes, size_t thread_count,
+                      const std::vector<Point>& points = {});
+
+    // Дуги клик уровня: для граничных вершин по порядку клеток и номеров
+    // вершин - число дуг, затем концы и веса всех дуг подряд
+    struct Cliques {
+        std::vector<uint32_t> arc_counts;
+        std::vector<VertexId> targets;
+        std::vector<Weight> weights;
+    };
+
+    // Восстановление по ранее посчитанному разбиению с настройкой
+    MultilevelOverlay(const Graph& graph, Partition partition, size_t thread_count);
+
+    // Восстановление по разбиению и кликам, посчитанным на тех же весах
+    MultilevelOverlay(const Graph& graph, Partition partition, const std::vector<Cliques>& cliques);
+
+    // Пересчёт клик по текущим весам рёбер графа, 0 потоков - по числу ядер
+    void Customize(size_t thread_count);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    const Partition& GetPartition() const;
+
+    std::vector<Cliques> GetCliques() const;
+
+    size_t GetLevelCount() const;
+
+    // Число вершин, обработанных последним запросом
+    size_t GetSettledCount() const;
+
+private:
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+    static constexpr Weight ZERO_WEIGHT{};
+
+    struct CliqueArc {
+        VertexId to;
+        Weight weight;
+    };
+
+    struct Level {
+        // Вершины поиска внутри клетки в формате CSR по клеткам: на нижнем
+        // уровне - все вершины клетки, выше - граничные вершины клеток
+        // уровнем ниже. member_indexes - номер вершины среди вершин клетки
+        std::vector<uint32_t> member_offsets;
+        std::vector<VertexId> members;
+        std::vector<uint32_t> member_indexes;
+
+        // Граничные вершины клетки: есть ребро в другую клетку или из неё
+        std::vector<uint32_t> boundary_offsets;
+        std::vector<VertexId> boundary;
+        std::vector<uint32_t> boundary_indexes;
+
+        // Дуги клик в формате CSR по граничным вершинам в порядке boundary:
+        // кратчайшие пути внутри клетки до других её граничных вершин.
+        // В reverse_arcs те же дуги по концам, to - начало дуги
+        std::vector<size_t> arc_offsets;
+        std::vector<CliqueArc> arcs;
+        std::vector<size_t> reverse_arc_offsets;
+        std::vector<CliqueArc> reverse_arcs;
+    };
+
+    // Дуга пути до раскрытия: исходное ребро или, при edge == NO_EDGE,
+    // дуга клики уровня level
+    struct Arc {
+        VertexId from;
+        VertexId to;
+        EdgeId edge;
+        uint32_t level;
+    };
+
+    struct Parent {
+        VertexId from = 0;
+        EdgeId edge = NO_EDGE;
+        uint32_t level = 0;
+    };
+
+    struct QueueEntry {
+        Weight weight;
+        VertexId vertex;
+
+        bool operator>(const QueueEntry& other) const {
+            return weight > other.weight;
+        }
+    };
+
+    // Буферы поиска внутри одной клетки, индексы - номера среди вершин клетки.
+    // passes_boundary - путь дерева поиска проходит через другую граничную
+    // вершину клетки с весом строго между нулём и весом всего пути
+    struct CellSearch {
+        std::vector<Weight> weights;
+        std::vector<Parent> parents;
+        std::vector<char> settled;
+        std::vector<char> passes_boundary;
+        std::vector<QueueEntry> heap;
+    };
+
+    // Метка вершины в запросе. В поиске от цели parent.from - следующая
+    // вершина пути, а не предыдущая
+    struct Label {
+        Weight weight = ZERO_WEIGHT;
+        uint32_t epoch = 0;
+        Parent parent;
+    };
+
+    // Состояние разбиения: смежность вершин без учёта направления рёбер
+    // в формате CSR и порядок вершин, клетки - его отрезки. Метки вершин
+    // различают диапазоны, устаревшие отличаются по значению mark
+    struct Partitioner {
+        std::vector<uint32_t> offsets;
+        std::vector<VertexId> neighbors;
+        const std::vector<Point>& points;
+        std::vector<VertexId> vertices;
+        std::vector<uint32_t> marks;
+        uint32_t mark = 0;
+    };
+
+    void CheckWeights() const;
+    void CheckPartition() const;
+    void PrepareQueries();
+    void BuildPartition(const std::vector<size_t>& cell_sizes, const std::vector<Point>& points);
+
+    // Упорядочивает vertices[begin, end) так, чтобы граница middle из
+    // [first, last] резала меньше всего рёбер, и возвращает её
+    static size_t Bisect(Partitioner& partitioner, size_t begin, size_t end, size_t first, size_t last,
+                         size_t target);
+
+    // Упорядочивает vertices[begin, end) обходом в ширину внутри диапазона
+    static void OrderByDistance(Partitioner& partitioner, size_t begin, size_t end);
+
+    // Число рёбер между [begin, middle) и [middle, end) и граница middle из
+    // [first, last], при которой оно меньше всего; при равенстве - ближайшая
+    // к target
+    static std::pair<int64_t, size_t> FindCut(Partitioner& partitioner, size_t begin, size_t end,
+                                              size_t first, size_t last, size_t target);
+    void BuildLevels();
+    void BuildReverseArcs(size_t level);
+
+    // Номер граничной вершины в boundary уровня или NONE
+    uint32_t GetBoundaryRow(size_t level, VertexId vertex) const;
+
+    // on_arc(to, weight) для дуг клики уровня level из граничной вершины
+    // vertex, с reverse - on_arc(from, weight) для дуг в неё
+    template <typename OnArc>
+    void ForEachCliqueArc(size_t level, VertexId vertex, bool reverse, OnArc&& on_arc) const;
+
+    // Поиск из from внутри его клетки уровня level: на нижнем уровне по
+    // рёбрам клетки, выше - по кликам и рёбрам между клетками уровнем ниже.
+    // С to поиск останавливается на нём
+    void SearchCell(size_t level, VertexId from, std::optional<VertexId> to, CellSearch& search) const;
+    void CustomizeCell(size_t level, uint32_t cell, CellSearch& search,
+                       std::vector<std::vector<CliqueArc>>& rows) const;
+
+    int GetQueryLevel(VertexId vertex, VertexId from, VertexId to) const;
+    void UnpackArc(const Arc& arc, std::vector<EdgeId>& edges) const;
+
+    const Graph& graph_;
+    Partition partition_;
+    std::vector<Level> levels_;
+
+    // Входящие рёбра вершин в формате CSR для поиска от цели
+    std::vector<uint32_t> reverse_offsets_;
+    std::vector<EdgeId> reverse_edges_;
+
+    // Буферы запроса по направлениям: [0] - поиск от начала, [1] - от цели
+    // по обратным дугам. Устаревшие метки отличаются по номеру поиска
+    mutable uint32_t epoch_ = 0;
+    mutable std::array<std::vector<Label>, 2> labels_;
+    mutable std::array<std::vector<QueueEntry>, 2> heaps_;
+    mutable CellSearch unpack_search_;
+    mutable size_t settled_count_ = 0;
+};
+
+template <typename Weight>
+MultilevelOverlay<Weight>::MultilevelOverlay(const Graph& graph, const std::vector<size_t>& cell_sizes,
+                                             size_t thread_count, const std::vector<Point>& points)
+    : graph_(graph)
+{
+    CheckWeights();
+    for (size_t level = 0; level < cell_sizes.size(); ++level) {
+        if (cell_sizes[level] == 0 || (level > 0 && cell_sizes[level] <= cell_sizes[level - 1])) {
+            throw std::invalid_argument("Overlay cell sizes should be positive and increasing");
+        }
+    }
+    if (!points.empty() && points.size() != graph.GetVertexCount()) {
+        throw std::invalid_argument("Overlay points do not match the graph");
+    }
+    PrepareQueries();
+    BuildPartition(cell_sizes, points);
+    BuildLevels();
+    Customize(thread_count);
+}
+
+template <typename Weight>
+MultilevelOverlay<Weight>::MultilevelOverlay(const Graph& graph, Partition partition, size_t thread_count)
+    : graph_(graph)
+    , partition_(std::move(partition))
+{
+    CheckWeights();
+    CheckPartition();
+    PrepareQueries();
+    BuildLevels();
+    Customize(thread_count);
+}
+
+template <typename Weight>
+MultilevelOverlay<Weight>::MultilevelOverlay(const Graph& graph, Partition partition,
+                                             const std::vector<Cliques>& cliques)
+    : graph_(graph)
+    , partition_(std::move(partition))
+{
+    CheckWeights();
+    CheckPartition();
+    PrepareQueries();
+    BuildLevels();
+
+    if (cliques.size() != levels_.size()) {
+        throw std::invalid_argument("Overlay cliques do not match the partition");
+    }
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        Level& data = levels_[level];
+        const Cliques& level_cliques = cliques[level];
+        if (level_cliques.arc_counts.size() != data.boundary.size()
+            || level_cliques.targets.size() != level_cliques.weights.size()) {
+            throw std::invalid_argument("Overlay cliques do not match the partition");
+        }
+
+        data.arc_offsets.assign(data.boundary.size() + 1, 0);
+        for (size_t row = 0; row < data.boundary.size(); ++row) {
+            data.arc_offsets[row + 1] = data.arc_offsets[row] + level_cliques.arc_counts[row];
+        }
+        if (data.arc_offsets.back() != level_cliques.targets.size()) {
+            throw std::invalid_argument("Overlay cliques do not match the partition");
+        }
+
+        // Дуга клики соединяет граничные вершины одной клетки
+        const auto& cells = partition_[level];
+        data.arcs.clear();
+        data.arcs.reserve(level_cliques.targets.size());
+        for (size_t row = 0; row < data.boundary.size(); ++row) {
+            for (size_t arc = data.arc_offsets[row]; arc < data.arc_offsets[row + 1]; ++arc) {
+                const VertexId to = level_cliques.targets[arc];
+                if (to >= graph_.GetVertexCount() || data.boundary_indexes[to] == NONE
+                    || cells[to] != cells[data.boundary[row]]) {
+                    throw std::invalid_argument("Overlay cliques do not match the partition");
+                }
+                data.arcs.push_back({to, level_cliques.weights[arc]});
+            }
+        }
+        BuildReverseArcs(level);
+    }
+}
+
+template <typename Weight>
+void MultilevelOverlay<Weight>::CheckWeights() const {
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        if (graph_.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+void MultilevelOverlay<Weight>::CheckPartition() const {
+    for (size_t level = 0; level < partition_.size(); ++level) {
+        const auto& cells = partition_[level];
+        if (cells.size() != graph_.GetVertexCount()) {
+            throw std::invalid_argument("Overlay partition does not match the graph");
+        }
+        if (level == 0) {
+            continue;
+        }
+        // Клетки вложены: вершины одной клетки нижнего уровня в одной клетке верхнего
+        std::vector<uint32_t> upper(cells.size(), NONE);
+        for (VertexId vertex = 0; vertex < cells.size(); ++vertex) {
+            uint32_t& cell = upper[partition_[level - 1][vertex]];
+            if (cell != NONE && cell != cells[vertex]) {
+                throw std::invalid_argument("Overlay partition levels are not nested");
+            }
+            cell = cells[vertex];
+        }
+    }
+}
+
+template <typename Weight>
+void MultilevelOverlay<Weight>::PrepareQueries() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    reverse_offsets_.assign(vertex_count + 1, 0);
+    reverse_edges_.clear();
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        graph_.ForEachOutgoingEdge(vertex, [&](EdgeId, VertexId edge_to, const Weight&) {
+            ++reverse_offsets_[edge_to + 1];
+        });
+    }
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        reverse_offsets_[vertex + 1] += reverse_offsets_[vertex];
+    }
+    reverse_edges_.resize(reverse_offsets_.back());
+    std::vector<uint32_t> fill(reverse_offsets_.begin(), std::prev(reverse_offsets_.end()));
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        graph_.ForEachOutgoingEdge(vertex, [&](EdgeId edge_id, VertexId edge_to, const Weight&) {
+            reverse_edges_[fill[edge_to]++] = edge_id;
+        });
+    }
+
+    for (auto& labels : labels_) {
+        labels.assign(vertex_count, Label{});
+    }
+    epoch_ = 0;
+}
+
+template <typename Weight>
+size_t MultilevelOverlay<Weight>::Bisect(Partitioner& partitioner, size_t begin, size_t end, size_t first,
+                                         size_t last, size_t target) {
+    OrderByDistance(partitioner, begin, end);
+    auto [best_cut, best_middle] = FindCut(partitioner, begin, end, first, last, target);
+    if (partitioner.points.empty()) {
+        return best_middle;
+    }
+
+    // Разрезы прямыми - порядки по проекциям точек на четыре направления
+    const auto range_begin = partitioner.vertices.begin() + static_cast<std::ptrdiff_t>(begin);
+    const auto range_end = partitioner.vertices.begin() + static_cast<std::ptrdiff_t>(end);
+    std::vector<VertexId> best_order(range_begin, range_end);
+    static constexpr std::array<Point, 4> directions = {{{1.0, 0.0}, {0.0, 1.0}, {1.0, 1.0}, {1.0, -1.0}}};
+    for (const auto& [dx, dy] : directions) {
+        const auto& points = partitioner.points;
+        std::sort(range_begin, range_end, [&points, dx = dx, dy = dy](VertexId lhs, VertexId rhs) {
+            const double lhs_projection = points[lhs].first * dx + points[lhs].second * dy;
+            const double rhs_projection = points[rhs].first * dx + points[rhs].second * dy;
+            return lhs_projection < rhs_projection || (lhs_projection == rhs_projection && lhs < rhs);
+        });
+        const auto [cut, middle] = FindCut(partitioner, begin, end, first, last, target);
+        if (cut < best_cut) {
+            best_cut = cut;
+            best_middle = middle;
+            best_order.assign(range_begin, range_end);
+        }
+    }
+    std::copy(best_order.begin(), best_order.end(), range_begin);
+    return best_middle;
+}
+
+template <typename Weight>
+void MultilevelOverlay<Weight>::OrderByDistance(Partitioner& partitioner, size_t begin, size_t end) {
+    auto& vertices = partitioner.vertices;
+    auto& marks = partitioner.marks;
+    uint32_t& mark = partitioner.mark;
+    std::vector<VertexId> queue;
+    queue.reserve(end - begin);
+
+    // Метка mark - вершина диапазона, mark + 1 - уже в очереди. Части
+    // диапазона, не связанные с start, обходятся следом. Возвращает
+    // последнюю вершину, достигнутую из start
+    const auto traverse = [&](VertexId start) {
+        mark += 2;
+        for (size_t index = begin; index < end; ++index) {
+            marks[vertices[index]] = mark;
+        }
+        queue.clear();
+        const auto visit = [&](VertexId seed) {
+            marks[seed] = mark + 1;
+            queue.push_back(seed);
+            for (size_t head = queue.size() - 1; head < queue.size(); ++head) {
+                const VertexId vertex = queue[head];
+                const uint32_t neighbors_end = partitioner.offsets[vertex + 1];
+                for (uint32_t index = partitioner.offsets[vertex]; index < neighbors_end; ++index) {
+                    const VertexId neighbor = partitioner.neighbors[index];
+                    if (marks[neighbor] == mark) {
+                        marks[neighbor] = mark + 1;
+                        queue.push_back(neighbor);
+                    }
+                }
+            }
+        };
+        visit(start);
+        const VertexId farthest = queue.back();
+        for (size_t index = begin; index < end && queue.size() < end - begin; ++index) {
+            if (marks[vertices[index]] == mark) {
+                visit(vertices[index]);
+            }
+        }
+        return farthest;
+    };
+
+    // Обход от самой дальней вершины начинается с края области, и его
+    // фронты режут её поперёк
+    traverse(traverse(vertices[begin]));
+    std::copy(queue.begin(), queue.end(), vertices.begin() + static_cast<std::ptrdiff_t>(begin));
+}
+
+template <typename Weight>
+std::pair<int64_t, size_t> MultilevelOverlay<Weight>::FindCut(Partitioner& partitioner,
+                                                              size_t begin, size_t end,
+                                                              size_t first, size_t last, size_t target) {
+    auto& marks = partitioner.marks;
+    uint32_t& mark = partitioner.mark;
+
+    // Разрез считается по мере добавления вершин в начало: метка mark - 1
+    // у вершины диапазона, mark - у уже добавленной
+    mark += 2;
+    for (size_t index = begin; index < end; ++index) {
+        marks[partitioner.vertices[index]] = mark - 1;
+    }
+
+    const auto distance = [target](size_t position) {
+        return position < target ? target - position : position - target;
+    };
+    int64_t cut = 0;
+    int64_t best_cut = 0;
+    size_t best_middle = target;
+    for (size_t middle = begin + 1; middle <= end; ++middle) {
+        const VertexId vertex = partitioner.vertices[middle - 1];
+        for (uint32_t index = partitioner.offsets[vertex]; index < partitioner.offsets[vertex + 1]; ++index) {
+            const uint32_t neighbor_mark = marks[partitioner.neighbors[index]];
+            if (neighbor_mark == mark) {
+                --cut;
+            } else if (neighbor_mark == mark - 1) {
+                ++cut;
+            }
+        }
+        marks[vertex] = mark;
+
+        if (middle >= first && middle <= last
+            && (middle == first || cut < best_cut
+                || (cut == best_cut && distance(middle) < distance(best_middle)))) {
+            best_cut = cut;
+            best_middle = middle;
+        }
+    }
+    return {best_cut, best_middle};
+}
+
+template <typename Weight>
+void MultilevelOverlay<Weight>::BuildPartition(const std::vector<size_t>& cell_sizes,
+                                               const std::vector<Point>& points) {
+    const size_t vertex_count = graph_.GetVertexCount();
+
+    Partitioner partitioner{{}, {}, points, {}, std::vector<uint32_t>(vertex_count, 0), 0};
+    {
+        std::vector<std::pair<VertexId, VertexId>> links;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            graph_.ForEachOutgoingEdge(vertex, [&](EdgeId, VertexId edge_to, const Weight&) {
+                if (edge_to != vertex) {
+                    links.emplace_back(vertex, edge_to);
+                    links.emplace_back(edge_to, vertex);
+                }
+            });
+        }
+        std::sort(links.begin(), links.end());
+        links.erase(std::unique(links.begin(), links.end()), links.end());
+        partitioner.offsets.assign(vertex_count + 1, 0);
+        partitioner.neighbors.reserve(links.size());
+        for (const auto& [from, to] : links) {
+            ++partitioner.offsets[from + 1];
+            partitioner.neighbors.push_back(to);
+        }
+        for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+            partitioner.offsets[vertex + 1] += partitioner.offsets[vertex];
+        }
+    }
+
+    size_t level_count = 0;
+    while (level_count < cell_sizes.size() && cell_sizes[level_count] < vertex_count) {
+        ++level_count;
+    }
+    partition_.assign(level_count, std::vector<uint32_t>(vertex_count, 0));
+
+    // Клетки - отрезки перестановки вершин. Сверху вниз каждая клетка
+    // уровнем выше делится пополам, пока части не станут не больше размера
+    // клетки уровня; так клетки уровней вложены
+    auto& vertices = partitioner.vertices;
+    vertices.resize(vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        vertices[vertex] = vertex;
+    }
+
+    std::vector<std::pair<size_t, size_t>> cells = {{0, vertex_count}};
+    for (size_t level = level_count; level-- > 0;) {
+        const size_t max_size = cell_sizes[level];
+        std::vector<std::pair<size_t, size_t>> parts;
+        std::vector<std::pair<size_t, size_t>> stack(cells.rbegin(), cells.rend());
+        while (!stack.empty()) {
+            const auto [begin, end] = stack.back();
+            stack.pop_back();
+            const size_t size = end - begin;
+            if (size <= max_size) {
+                parts.emplace_back(begin, end);
+                continue;
+            }
+            // Части делятся в отношении числа будущих клеток, чтобы все
+            // клетки уровня вышли примерно одного размера. Граница сдвигается
+            // не больше чем на десятую часть меньшей части и так, чтобы обе
+            // части делились на своё число клеток
+            const size_t part_count = (size + max_size - 1) / max_size;
+            const size_t left_count = part_count / 2;
+            const size_t right_size = (part_count - left_count) * max_size;
+            const size_t target = size * left_count / part_count;
+            const size_t slack = std::min(target, size - target) / 10;
+            const size_t first = begin + std::max(target - slack, size > right_size ? size - right_size : 0);
+            const size_t last = begin + std::min(target + slack, left_count * max_size);
+            const size_t middle = Bisect(partitioner, begin, end, first, last, begin + target);
+            stack.emplace_back(middle, end);
+            stack.emplace_back(begin, middle);
+        }
+
+        for (size_t cell = 0; cell < parts.size(); ++cell) {
+            for (size_t index = parts[cell].first; index < parts[cell].second; ++index) {
+                partition_[level][vertices[index]] = static_cast<uint32_t>(cell);
+            }
+        }
+        cells = std::move(parts);
+    }
+}
+
+template <typename Weight>
+void MultilevelOverlay<Weight>::BuildLevels() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    levels_.assign(partition_.size(), Level{});
+
+    for (size_t level = 0; level < partition_.size(); ++level) {
+        const auto& cells = partition_[level];
+        Level& data = levels_[level];
+        const uint32_t cell_count = vertex_count == 0
+                ? 0 : *std::max_element(cells.begin(), cells.end()) + 1;
+
+        std::vector<char> is_boundary(vertex_count, 0);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            graph_.ForEachOutgoingEdge(vertex, [&](EdgeId, VertexId edge_to, const Weight&) {
+                if (cells[edge_to] != cells[vertex]) {
+                    is_boundary[vertex] = 1;
+                    is_boundary[edge_to] = 1;
+                }
+            });
+        }
+
+        // Вершины поиска выше нижнего уровня - граничные вершины уровнем ниже,
+        // которые по вложенности включают граничные вершины этого уровня
+        const auto is_member = [&](VertexId vertex) {
+            return level == 0 || levels_[level - 1].boundary_indexes[vertex] != NONE;
+        };
+
+        const auto fill_groups = [&](const auto& is_in_group, std::vector<uint32_t>& offsets,
+                                     std::vector<VertexId>& vertices, std::vector<uint32_t>& indexes) {
+            offsets.assign(cell_count + 1, 0);
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                if (is_in_group(vertex)) {
+                    ++offsets[cells[vertex] + 1];
+                }
+            }
+            for (uint32_t cell = 0; cell < cell_count; ++cell) {
+                offsets[cell + 1] += offsets[cell];
+            }
+            vertices.resize(offsets.back());
+            indexes.assign(vertex_count, NONE);
+            std::vector<uint32_t> fill(offsets.begin(), std::prev(offsets.end()));
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                if (is_in_group(vertex)) {
+                    const uint32_t slot = fill[cells[vertex]]++;
+                    vertices[slot] = vertex;
+                    indexes[vertex] = slot - offsets[cells[vertex]];
+                }
+            }
+        };
+
+        fill_groups(is_member, data.member_offsets, data.members, data.member_indexes);
+        fill_groups([&](VertexId vertex) {
+            return is_boundary[vertex] != 0;
+        }, data.boundary_offsets, data.boundary, data.boundary_indexes);
+    }
+}
+
+template <typename Weight>
+void MultilevelOverlay<Weight>::Customize(size_t thread_count) {
+    parallel::ThreadPool pool(thread_count);
+    // Клики уровня считаются по кликам уровнем ниже
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        Level& data = levels_[level];
+        const size_t cell_count = data.boundary_offsets.size() - 1;
+        std::vector<std::vector<CliqueArc>> rows(data.boundary.size());
+        pool.parallelFor(cell_count, [this, level, &rows](size_t cell) {
+            thread_local CellSearch search;
+            CustomizeCell(level, static_cast<uint32_t>(cell), search, rows);
+        });
+
+        data.arc_offsets.assign(rows.size() + 1, 0);
+        for (size_t row = 0; row < rows.size(); ++row) {
+            data.arc_offsets[row + 1] = data.arc_offsets[row] + rows[row].size();
+        }
+        data.arcs.clear();
+        data.arcs.reserve(data.arc_offsets.back());
+        for (const auto& row : rows) {
+            data.arcs.insert(data.arcs.end(), row.begin(), row.end());
+        }
+        BuildReverseArcs(level);
+    }
+}
+
+template <typename Weight>
+void MultilevelOverlay<Weight>::BuildReverseArcs(size_t level) {
+    Level& data = levels_[level];
+    const size_t row_count = data.boundary.size();
+    data.reverse_arc_offsets.assign(row_count + 1, 0);
+    for (const CliqueArc& arc : data.arcs) {
+        ++data.reverse_arc_offsets[GetBoundaryRow(level, arc.to) + 1];
+    }
+    for (size_t row = 0; row < row_count; ++row) {
+        data.reverse_arc_offsets[row + 1] += data.reverse_arc_offsets[row];
+    }
+    data.reverse_arcs.resize(data.arcs.size());
+    std::vector<size_t> fill(data.reverse_arc_offsets.begin(), std::prev(data.reverse_arc_offsets.end()));
+    for (size_t row = 0; row < row_count; ++row) {
+        for (size_t arc = data.arc_offsets[row]; arc < data.arc_offsets[row + 1]; ++arc) {
+            const CliqueArc& forward = data.arcs[arc];
+            const uint32_t reverse_row = GetBoundaryRow(level, forward.to);
+            data.reverse_arcs[fill[reverse_row]++] = {data.boundary[row], forward.weight};
+        }
+    }
+}
+
+template <typename Weight>
+void MultilevelOverlay<Weight>::CustomizeCell(size_t level, uint32_t cell, CellSearch& search,
+                                              std::vector<std::vector<CliqueArc>>& rows) const {
+    const Level& data = levels_[level];
+    const uint32_t boundary_begin = data.boundary_offsets[cell];
+    const uint32_t boundary_end = data.boundary_offsets[cell + 1];
+
+    // Дуга, кратчайший путь которой проходит через другую граничную вершину,
+    // не нужна: её заменяют две более лёгкие дуги клики
+    for (uint32_t row = boundary_begin; row < boundary_end; ++row) {
+        SearchCell(level, data.boundary[row], std::nullopt, search);
+        std::vector<CliqueArc>& arcs = rows[row];
+        arcs.clear();
+        for (uint32_t column = boundary_begin; column < boundary_end; ++column) {
+            const VertexId to = data.boundary[column];
+            const uint32_t index = data.member_indexes[to];
+            if (column != row && search.settled[index] && !search.passes_boundary[index]) {
+                arcs.push_back({to, search.weights[index]});
+            }
+        }
+    }
+}
+
+template <typename Weight>
+uint32_t MultilevelOverlay<Weight>::GetBoundaryRow(size_t level, VertexId vertex) const {
+    const Level& data = levels_[level];
+    const uint32_t index = data.boundary_indexes[vertex];
+    return index == NONE ? NONE : data.boundary_offsets[partition_[level][vertex]] + index;
+}
+
+template <typename Weight>
+template <typename OnArc>
+void MultilevelOverlay<Weight>::ForEachCliqueArc(size_t level, VertexId vertex, bool reverse,
+                                                 OnArc&& on_arc) const {
+    const uint32_t row = GetBoundaryRow(level, vertex);
+    if (row == NONE) {
+        return;
+    }
+    const Level& data = levels_[level];
+    const auto& offsets = reverse ? data.reverse_arc_offsets : data.arc_offsets;
+    const auto& arcs = reverse ? data.reverse_arcs : data.arcs;
+    for (size_t arc = offsets[row]; arc < offsets[row + 1]; ++arc) {
+        on_arc(arcs[arc].to, arcs[arc].weight);
+    }
+}
+
+template <typename Weight>
+void MultilevelOverlay<Weight>::SearchCell(size_t level, VertexId from, std::optional<VertexId> to,
+                                           CellSearch& search) const {
+    const Level& data = levels_[level];
+    const auto& cells = partition_[level];
+    const uint32_t cell = cells[from];
+    const size_t member_count = data.member_offsets[cell + 1] - data.member_offsets[cell];
+
+    search.weights.assign(member_count, InfiniteWeight<Weight>());
+    search.parents.assign(member_count, Parent{});
+    search.settled.assign(member_count, 0);
+    search.passes_boundary.assign(member_count, 0);
+    search.heap.clear();
+
+    const auto relax = [&](VertexId vertex, VertexId edge_to, Weight weight, EdgeId edge,
+                           uint32_t arc_level) {
+        const uint32_t index = data.member_indexes[edge_to];
+        if (weight < search.weights[index]) {
+            const uint32_t vertex_index = data.member_indexes[vertex];
+            const Weight vertex_weight = search.weights[vertex_index];
+            search.weights[index] = weight;
+            search.parents[index] = Parent{vertex, edge, arc_level};
+            search.passes_boundary[index] = search.passes_boundary[vertex_index]
+                    || (vertex != from && data.boundary_indexes[vertex] != NONE
+                        && ZERO_WEIGHT < vertex_weight && vertex_weight < weight);
+            search.heap.push_back({weight, edge_to});
+            std::push_heap(search.heap.begin(), search.heap.end(), std::greater<QueueEntry>{});
+        }
+    };
+
+    search.weights[data.member_indexes[from]] = ZERO_WEIGHT;
+    search.heap.push_back({ZERO_WEIGHT, from});
+    while (!search.heap.empty()) {
+        std::pop_heap(search.heap.begin(), search.heap.end(), std::greater<QueueEntry>{});
+        const QueueEntry entry = search.heap.back();
+        search.heap.pop_back();
+
+        const uint32_t index = data.member_indexes[entry.vertex];
+        if (search.settled[index] || entry.weight > search.weights[index]) {
+            continue;
+        }
+        search.settled[index] = 1;
+        if (to == entry.vertex) {
+            break;
+        }
+
+        if (level == 0) {
+            graph_.ForEachOutgoingEdge(entry.vertex, [&](EdgeId edge_id, VertexId edge_to,
+                                                         const Weight& edge_weight) {
+                if (cells[edge_to] == cell) {
+                    relax(entry.vertex, edge_to, entry.weight + edge_weight, edge_id, 0);
+                }
+            });
+            continue;
+        }
+
+        const size_t lower = level - 1;
+        const auto& lower_cells = partition_[lower];
+        ForEachCliqueArc(lower, entry.vertex, false, [&](VertexId arc_to, const Weight& arc_weight) {
+            relax(entry.vertex, arc_to, entry.weight + arc_weight, NO_EDGE, static_cast<uint32_t>(lower));
+        });
+        graph_.ForEachOutgoingEdge(entry.vertex, [&](EdgeId edge_id, VertexId edge_to,
+                                                     const Weight& edge_weight) {
+            if (cells[edge_to] == cell && lower_cells[edge_to] != lower_cells[entry.vertex]) {
+                relax(entry.vertex, edge_to, entry.weight + edge_weight, edge_id, 0);
+            }
+        });
+    }
+}
+
+template <typename Weight>
+int MultilevelOverlay<Weight>::GetQueryLevel(VertexId vertex, VertexId from, VertexId to) const {
+    // Клетки вложены: если вершина в другой клетке на уровне l, то и на всех ниже
+    for (size_t level = partition_.size(); level-- > 0;) {
+        const auto& cells = partition_[level];
+        if (cells[vertex] != cells[from] && cells[vertex] != cells[to]) {
+            return static_cast<int>(level);
+        }
+    }
+    return -1;
+}
+
+template <typename Weight>
+std::optional<typename MultilevelOverlay<Weight>::RouteInfo>
+MultilevelOverlay<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    if (++epoch_ == 0) {
+        for (auto& labels : labels_) {
+            for (Label& label : labels) {
+                label.epoch = 0;
+            }
+        }
+        epoch_ = 1;
+    }
+    settled_count_ = 0;
+
+    // Лучший найденный путь - через вершину meeting, достигнутую с обеих сторон
+    std::optional<Weight> best;
+    VertexId meeting = from;
+
+    const auto reach = [&](size_t side, VertexId vertex, const Weight& weight, const Parent& parent) {
+        Label& label = labels_[side][vertex];
+        if (label.epoch == epoch_ && !(weight < label.weight)) {
+            return;
+        }
+        label = Label{weight, epoch_, parent};
+        auto& heap = heaps_[side];
+        heap.push_back({weight, vertex});
+        std::push_heap(heap.begin(), heap.end(), std::greater<QueueEntry>{});
+
+        const Label& other = labels_[1 - side][vertex];
+        if (other.epoch == epoch_ && (!best || weight + other.weight < *best)) {
+            best = weight + other.weight;
+            meeting = vertex;
+        }
+    };
+
+    heaps_[0].clear();
+    heaps_[1].clear();
+    reach(0, from, ZERO_WEIGHT, Parent{});
+    reach(1, to, ZERO_WEIGHT, Parent{});
+
+    // Поиски идут по очереди от меньшего ключа, пока сумма ключей не
+    // превзойдёт лучший путь. Когда одна сторона исчерпана, лучший путь
+    // уже найден, если он есть
+    while (!heaps_[0].empty() || !heaps_[1].empty()) {
+        if (best && (heaps_[0].empty() || heaps_[1].empty()
+                     || !(heaps_[0].front().weight + heaps_[1].front().weight < *best))) {
+            break;
+        }
+        const size_t side = heaps_[1].empty()
+                || (!heaps_[0].empty() && !(heaps_[1].front().weight < heaps_[0].front().weight)) ? 0 : 1;
+        auto& heap = heaps_[side];
+        std::pop_heap(heap.begin(), heap.end(), std::greater<QueueEntry>{});
+        const QueueEntry entry = heap.back();
+        heap.pop_back();
+        if (entry.weight > labels_[side][entry.vertex].weight) {
+            continue;
+        }
+        ++settled_count_;
+
+        const int query_level = GetQueryLevel(entry.vertex, from, to);
+        const auto is_cut = [&](VertexId other) {
+            return query_level < 0 || partition_[query_level][other] != partition_[query_level][entry.vertex];
+        };
+
+        if (query_level >= 0) {
+            const auto level = static_cast<uint32_t>(query_level);
+            ForEachCliqueArc(level, entry.vertex, side == 1, [&](VertexId arc_end, const Weight& arc_weight) {
+                reach(side, arc_end, entry.weight + arc_weight, Parent{entry.vertex, NO_EDGE, level});
+            });
+        }
+        if (side == 0) {
+            graph_.ForEachOutgoingEdge(entry.vertex, [&](EdgeId edge_id, VertexId edge_to,
+                                                         const Weight& edge_weight) {
+                if (is_cut(edge_to)) {
+                    reach(0, edge_to, entry.weight + edge_weight, Parent{entry.vertex, edge_id, 0});
+                }
+            });
+            continue;
+        }
+        for (uint32_t index = reverse_offsets_[entry.vertex]; index < reverse_offsets_[entry.vertex + 1];
+             ++index) {
+            const EdgeId edge_id = reverse_edges_[index];
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (is_cut(edge.from)) {
+                reach(1, edge.from, entry.weight + edge.weight, Parent{entry.vertex, edge_id, 0});
+            }
+        }
+    }
+
+    if (!best) {
+        return std::nullopt;
+    }
+
+    std::vector<Arc> arcs;
+    for (VertexId vertex = meeting; vertex != from;) {
+        const Parent& parent = labels_[0][vertex].parent;
+        arcs.push_back(Arc{parent.from, vertex, parent.edge, parent.level});
+        vertex = parent.from;
+    }
+    std::reverse(arcs.begin(), arcs.end());
+    for (VertexId vertex = meeting; vertex != to;) {
+        const Parent& parent = labels_[1][vertex].parent;
+        arcs.push_back(Arc{vertex, parent.from, parent.edge, parent.level});
+        vertex = parent.from;
+    }
+
+    std::vector<EdgeId> edges;
+    for (const Arc& arc : arcs) {
+        UnpackArc(arc, edges);
+    }
+    return RouteInfo{*best, std::move(edges)};
+}
+
+template <typename Weight>
+void MultilevelOverlay<Weight>::UnpackArc(const Arc& arc, std::vector<EdgeId>& edges) const {
+    if (arc.edge != NO_EDGE) {
+        edges.push_back(arc.edge);
+        return;
+    }
+
+    // Путь по клике повторяется поиском внутри её клетки; буфер поиска
+    // освобождается до раскрытия вложенных дуг
+    SearchCell(arc.level, arc.from, arc.to, unpack_search_);
+    const Level& data = levels_[arc.level];
+    std::vector<Arc> arcs;
+    for (VertexId vertex = arc.to; vertex != arc.from;) {
+        const Parent& parent = unpack_search_.parents[data.member_indexes[vertex]];
+        arcs.push_back(Arc{parent.from, vertex, parent.edge, parent.level});
+        vertex = parent.from;
+    }
+    std::reverse(arcs.begin(), arcs.end());
+
+    for (const Arc& inner_arc : arcs) {
+        UnpackArc(inner_arc, edges);
+    }
+}
+
+template <typename Weight>
+const typename MultilevelOverlay<Weight>::Partition& MultilevelOverlay<Weight>::GetPartition() const {
+    return partition_;
+}
+
+template <typename Weight>
+std::vector<typename MultilevelOverlay<Weight>::Cliques> MultilevelOverlay<Weight>::GetCliques() const {
+    std::vector<Cliques> cliques(levels_.size());
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        const Level& data = levels_[level];
+        Cliques& level_cliques = cliques[level];
+        level_cliques.arc_counts.reserve(data.boundary.size());
+        for (size_t row = 0; row < data.boundary.size(); ++row) {
+            level_cliques.arc_counts.push_back(
+                static_cast<uint32_t>(data.arc_offsets[row + 1] - data.arc_offsets[row]));
+        }
+        level_cliques.targets.reserve(data.arcs.size());
+        level_cliques.weights.reserve(data.arcs.size());
+        for (const CliqueArc& arc : data.arcs) {
+            level_cliques.targets.push_back(arc.to);
+            level_cliques.weights.push_back(arc.weight);
+        }
+    }
+    return cliques;
+}
+
+template <typename Weight>
+size_t MultilevelOverlay<Weight>::GetLevelCount() const {
+    return partition_.size();
+}
+
+template <typename Weight>
+size_t MultilevelOverlay<Weight>::GetSettledCount() const {
+    return settled_count_;
+}
+
+}  // namespace graph
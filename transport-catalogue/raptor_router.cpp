@@ -0,0 +1,255 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+
+const double INFINITE_TIME = std::numeric_limits<double>::infinity();
+
+} // namespace
+
+void RaptorRouter::build(const TransportCatalogue &_catalogue, double _wait_time, double _velocity)
+{
+    wait_time_ = _wait_time;
+
+    stop_names_.clear();
+    stop_indexes_.clear();
+    lines_.clear();
+
+    for (const auto *stop : _catalogue.getSortedUsedStops())
+    {
+        stop_indexes_[stop->name_] = static_cast<StopIndex>(stop_names_.size());
+        stop_names_.push_back(stop->name_);
+    }
+
+    for (const auto *bus : _catalogue.getSortedBuses())
+    {
+        appendLine(bus->route_, bus->name_, _catalogue, _velocity);
+        if (!bus->is_circul_)
+        {
+            appendLine({bus->route_.rbegin(), bus->route_.rend()}, bus->name_,
+                       _catalogue, _velocity);
+        }
+    }
+
+    stop_lines_offsets_.assign(stop_names_.size() + 1, 0);
+    for (const auto &line : lines_)
+    {
+        for (const StopIndex stop : line.stops)
+        {
+            ++stop_lines_offsets_[stop + 1];
+        }
+    }
+    for (size_t stop = 0; stop < stop_names_.size(); ++stop)
+    {
+        stop_lines_offsets_[stop + 1] += stop_lines_offsets_[stop];
+    }
+
+    stop_lines_.resize(stop_lines_offsets_.back());
+    std::vector<uint32_t> fill_positions(stop_lines_offsets_.begin(),
+                                         std::prev(stop_lines_offsets_.end()));
+    for (uint32_t line = 0; line < lines_.size(); ++line)
+    {
+        const auto &stops = lines_[line].stops;
+        for (uint32_t position = 0; position < stops.size(); ++position)
+        {
+            stop_lines_[fill_positions[stops[position]]++] = {line, position};
+        }
+    }
+
+    arrivals_.assign(stop_names_.size(), INFINITE_TIME);
+    parents_.assign(stop_names_.size(), Parent{});
+    is_marked_.assign(stop_names_.size(), false);
+    line_first_positions_.assign(lines_.size(), NONE);
+    reached_stops_.clear();
+}
+
+void RaptorRouter::appendLine(const std::vector<std::string_view> &_stops,
+                              std::string_view _bus_name,
+                              const TransportCatalogue &_catalogue,
+                              double _velocity)
+{
+    Line line;
+    line.bus_name = _bus_name;
+    line.stops.reserve(_stops.size());
+    line.segment_times.reserve(_stops.size());
+
+    for (size_t position = 0; position < _stops.size(); ++position)
+    {
+        line.stops.push_back(stop_indexes_.at(_stops[position]));
+        if (position + 1 < _stops.size())
+        {
+            line.segment_times.push_back(
+                        _catalogue.getDistancesBetweenStops({_stops[position],
+                                                             _stops[position + 1]}).value() / _velocity);
+        }
+    }
+
+    lines_.push_back(std::move(line));
+}
+
+std::optional<std::pair<double, std::vector<domain::RouteItem>>>
+RaptorRouter::buildRoute(std::string_view _from, std::string_view _to) const
+{
+    if (stop_indexes_.count(_from) == 0U || stop_indexes_.count(_to) == 0U)
+    {
+        return {};
+    }
+
+    const StopIndex source = stop_indexes_.at(_from);
+    const StopIndex target = stop_indexes_.at(_to);
+
+    runRounds(source, target, INFINITE_TIME);
+
+    if (arrivals_[target] == INFINITE_TIME)
+    {
+        return {};
+    }
+
+    std::pair<double, std::vector<domain::RouteItem>> output;
+    output.first = arrivals_[target];
+
+    auto &items = output.second;
+    for (StopIndex stop = target; stop != source; )
+    {
+        const Parent &parent = parents_[stop];
+        const Line &line = lines_[parent.line];
+        const StopIndex board_stop = line.stops[parent.board_position];
+
+        items.emplace_back(domain::BusRouteInfo{
+                               line.bus_name,
+                               static_cast<int>(parent.alight_position - parent.board_position),
+                               parent.ride_time});
+        items.emplace_back(domain::WaitInfo{stop_names_[board_stop], wait_time_});
+
+        stop = board_stop;
+    }
+    std::reverse(items.begin(), items.end());
+
+    return output;
+}
+
+std::vector<std::pair<std::string_view, double>>
+RaptorRouter::buildIsochrone(std::string_view _from, double _max_time) const
+{
+    if (stop_indexes_.count(_from) == 0U)
+    {
+        return {};
+    }
+
+    runRounds(stop_indexes_.at(_from), NONE, _max_time);
+
+    std::vector<std::pair<std::string_view, double>> output;
+    output.reserve(reached_stops_.size());
+    for (const StopIndex stop : reached_stops_)
+    {
+        output.emplace_back(stop_names_[stop], arrivals_[stop]);
+    }
+
+    return output;
+}
+
+void RaptorRouter::runRounds(StopIndex _source, StopIndex _target, double _time_limit) const
+{
+    for (const StopIndex stop : reached_stops_)
+    {
+        arrivals_[stop] = INFINITE_TIME;
+        parents_[stop] = Parent{};
+    }
+    reached_stops_.clear();
+
+    arrivals_[_source] = 0.0;
+    reached_stops_.push_back(_source);
+    marked_stops_.assign(1, _source);
+
+    while (!marked_stops_.empty())
+    {
+        // Линии через улучшенные остановки просматриваются с самой ранней
+        // улучшенной позиции
+        for (const StopIndex stop : marked_stops_)
+        {
+            is_marked_[stop] = false;
+            for (uint32_t index = stop_lines_offsets_[stop];
+                 index < stop_lines_offsets_[stop + 1]; ++index)
+            {
+                const auto [line, position] = stop_lines_[index];
+                if (line_first_positions_[line] == NONE)
+                {
+                    queued_lines_.push_back(line);
+                    line_first_positions_[line] = position;
+                }
+                else
+                {
+                    line_first_positions_[line] = std::min(line_first_positions_[line], position);
+                }
+            }
+        }
+        marked_stops_.clear();
+
+        for (const uint32_t line : queued_lines_)
+        {
+            scanLine(line, line_first_positions_[line], _target, _time_limit);
+            line_first_positions_[line] = NONE;
+        }
+        queued_lines_.clear();
+
+        std::swap(marked_stops_, next_marked_stops_);
+    }
+}
+
+void RaptorRouter::scanLine(uint32_t _line, uint32_t _first_position,
+                            StopIndex _target, double _time_limit) const
+{
+    const Line &line = lines_[_line];
+
+    bool is_boarded = false;
+    double board_time = 0.0;
+    double ride_time = 0.0;
+    uint32_t board_position = 0;
+
+    for (uint32_t position = _first_position; position < line.stops.size(); ++position)
+    {
+        const StopIndex stop = line.stops[position];
+
+        if (is_boarded)
+        {
+            // Улучшения не лучше уже найденного прибытия в цель бесполезны
+            const double arrival = board_time + ride_time;
+            const bool is_in_limit = _target == NONE ? !(_time_limit < arrival)
+                                                     : arrival < arrivals_[_target];
+            if (arrival < arrivals_[stop] && is_in_limit)
+            {
+                if (arrivals_[stop] == INFINITE_TIME)
+                {
+                    reached_stops_.push_back(stop);
+                }
+                arrivals_[stop] = arrival;
+                parents_[stop] = {_line, board_position, position, ride_time};
+                if (!is_marked_[stop])
+                {
+                    is_marked_[stop] = true;
+                    next_marked_stops_.push_back(stop);
+                }
+            }
+        }
+
+        if (arrivals_[stop] != INFINITE_TIME)
+        {
+            const double candidate_board_time = arrivals_[stop] + wait_time_;
+            if (!is_boarded || candidate_board_time < board_time + ride_time)
+            {
+                is_boarded = true;
+                board_time = candidate_board_time;
+                ride_time = 0.0;
+                board_position = position;
+            }
+        }
+
+        if (is_boarded && position < line.segment_times.size())
+        {
+            ride_time += line.segment_times[position];
+        }
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef RAPTORROUTER_H
+#define RAPTORROUTER_H
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "transport_catalogue.h"
+
+// Поиск маршрута по раундам в духе RAPTOR: каждый раунд просматривает
+// последовательности остановок автобусов, улучшенных в предыдущем раунде,
+// без построения графа. Память линейна по числу остановок и суммарной
+// длине маршрутов.
+class RaptorRouter
+{
+public:
+    RaptorRouter() = default;
+
+    void build(const TransportCatalogue &_catalogue, double _wait_time, double _velocity);
+
+    std::optional<std::pair<double, std::vector<domain::RouteItem>>>
+    buildRoute(std::string_view _from, std::string_view _to) const;
+
+    // Остановки, до которых из _from можно доехать не дольше _max_time,
+    // и время в пути до них в порядке остановок
+    std::vector<std::pair<std::string_view, double>>
+    buildIsochrone(std::string_view _from, double _max_time) const;
+
+private:
+    using StopIndex = uint32_t;
+
+    static constexpr StopIndex NONE = UINT32_MAX;
+
+    // Одно направление маршрута автобуса
+    struct Line
+    {
+        std::string_view bus_name;
+        std::vector<StopIndex> stops;
+        // segment_times[i] - время в пути от stops[i] до stops[i + 1]
+        std::vector<double> segment_times;
+    };
+
+    // Откуда пришли на остановку: линия, позиции посадки и высадки, время в пути
+    struct Parent
+    {
+        uint32_t line = NONE;
+        uint32_t board_position = 0;
+        uint32_t alight_position = 0;
+        double ride_time = 0.0;
+    };
+
+    void appendLine(const std::vector<std::string_view> &_stops,
+                    std::string_view _bus_name,
+                    const TransportCatalogue &_catalogue,
+                    double _velocity);
+
+    // Раунды от _source. Прибытия не раньше прибытия в _target или,
+    // без цели (NONE), позже _time_limit отбрасываются
+    void runRounds(StopIndex _source, StopIndex _target, double _time_limit) const;
+
+    void scanLine(uint32_t _line, uint32_t _first_position,
+                  StopIndex _target, double _time_limit) const;
+
+    double wait_time_ = 0.0;
+
+    std::vector<std::string_view> stop_names_;
+    std::unordered_map<std::string_view, StopIndex> stop_indexes_;
+
+    std::vector<Line> lines_;
+
+    // Вхождения остановок в линии: (линия, позиция), сгруппированы по остановкам
+    std::vector<uint32_t> stop_lines_offsets_;
+    std::vector<std::pair<uint32_t, uint32_t>> stop_lines_;
+
+    // Буферы поиска, переиспользуются между запросами
+    mutable std::vector<double> arrivals_;
+    mutable std::vector<Parent> parents_;
+    mutable std::vector<StopIndex> reached_stops_;
+    mutable std::vector<StopIndex> marked_stops_;
+    mutable std::vector<StopIndex> next_marked_stops_;
+    mutable std::vector<bool> is_marked_;
+    mutable std::vector<uint32_t> line_first_positions_;
+    mutable std::vector<uint32_t> queued_lines_;
+};
+
+#endif // RAPTORROUTER_H
@@ -71,6 +71,84 @@ RequestHandler::RouteStat RequestHandler::getRouteInfo(std::string_view _from, s
     return route;
 }
 
+RequestHandler::RouteStat RequestHandler::getRouteInfo(std::string_view _from, std::string_view _to,
+                                                      const TransportRouter::RouteExclusions &_exclusions,
+                                                      const TransportRouter::RouteProfile &_profile) const
+{
+    const domain::Stop *stop_from = catalogue_.findStop(_from);
+    const domain::Stop *next_to = catalogue_.findStop(_to);
+
+    if (stop_from == nullptr || next_to == nullptr)
+    {
+        throw std::domain_error("getRouteInfo(): findStop returned nullptr");
+    }
+
+    return router_.buildRoute(stop_from->name_, next_to->name_, _exclusions, _profile);
+}
+
+RequestHandler::RouteStat RequestHandler::getRouteInfo(std::string_view _from, std::string_view _to,
+                                                      double _departure_time) const
+{
+    const domain::Stop *stop_from = catalogue_.findStop(_from);
+    const domain::Stop *next_to = catalogue_.findStop(_to);
+
+    if (stop_from == nullptr || next_to == nullptr)
+    {
+        throw std::domain_error("getRouteInfo(): findStop returned nullptr");
+    }
+
+    return router_.buildRoute(stop_from->name_, next_to->name_, _departure_time);
+}
+
+std::optional<double> RequestHandler::getTravelTime(std::string_view _from, std::string_view _to) const
+{
+    const domain::Stop *stop_from = catalogue_.findStop(_from);
+    const domain::Stop *next_to = catalogue_.findStop(_to);
+
+    if (stop_from == nullptr || next_to == nullptr)
+    {
+        throw std::domain_error("getTravelTime(): findStop returned nullptr");
+    }
+
+    return router_.computeTravelTime(stop_from->name_, next_to->name_);
+}
+
+TransportRouter::Isochrone RequestHandler::getIsochrone(std::string_view _from, double _max_time) const
+{
+    const domain::Stop *stop_from = catalogue_.findStop(_from);
+
+    if (stop_from == nullptr)
+    {
+        throw std::domain_error("getIsochrone(): findStop returned nullptr");
+    }
+
+    return router_.buildIsochrone(stop_from->name_, _max_time);
+}
+
+TransportRouter::RouteMatrix
+RequestHandler::getRouteMatrix(const std::vector<std::string_view> &_origins,
+                               const std::vector<std::string_view> &_destinations,
+                               bool _with_items) const
+{
+    std::vector<std::string_view> origins;
+    std::vector<std::string_view> destinations;
+    for (auto [names, stops] : {std::pair{&_origins, &origins}, std::pair{&_destinations, &destinations}})
+    {
+        stops->reserve(names->size());
+        for (const auto name : *names)
+        {
+            const domain::Stop *stop = catalogue_.findStop(name);
+            if (stop == nullptr)
+            {
+                throw std::domain_error("getRouteMatrix(): findStop returned nullptr");
+            }
+            stops->push_back(stop->name_);
+        }
+    }
+
+    return router_.buildRouteMatrix(origins, destinations, _with_items);
+}
+
 void RequestHandler::procRequests(const json::Document &_doc, std::ostream &_output) const
 {
     using namespace reader;
@@ -81,6 +159,12 @@ void RequestHandler::procRequests(const json::Document &_doc, std::ostream &_out
     auto array = builder.StartArray();
     for (const auto &query : queries)
     {
+        if (!query.error_message.empty())
+        {
+            array.Value(JsonReader::writeError(query.error_message, query.id));
+            continue;
+        }
+
         switch (query.type)
         {
         case TypeRequest::STOP :
@@ -93,7 +177,38 @@ void RequestHandler::procRequests(const json::Document &_doc, std::ostream &_out
             array.Value(JsonReader::writeMap(RenderMap(), query.id));
             break;
         case TypeRequest::ROUTE :
-            array.Value(JsonReader::writeRoute(getRouteInfo(query.from, query.to), query.id));
+            try
+            {
+                array.Value(JsonReader::writeRoute(
+                                query.departure_time.has_value()
+                                ? getRouteInfo(query.from, query.to, *query.departure_time)
+                                : getRouteInfo(query.from, query.to, query.exclusions, query.profile),
+                                query.id));
+            }
+            catch (const TransportRouter::RouteOptionsError &_error)
+            {
+                // Ошибка только этого запроса, остальные исключения - ошибки программы
+                array.Value(JsonReader::writeError(_error.what(), query.id));
+            }
+            break;
+        case TypeRequest::TRAVEL_TIME :
+            array.Value(JsonReader::writeTravelTime(getTravelTime(query.from, query.to), query.id));
+            break;
+        case TypeRequest::ISOCHRONE :
+        {
+            const auto stops = getIsochrone(query.from, query.max_time);
+            array.Value(JsonReader::writeIsochrone(
+                            stops,
+                            query.with_map ? std::optional(RenderIsochrone(stops, query.max_time))
+                                           : std::nullopt,
+                            query.id));
+            break;
+        }
+        case TypeRequest::ROUTE_MATRIX :
+            array.Value(JsonReader::writeRouteMatrix(
+                            getRouteMatrix(query.origins, query.destinations, query.with_items),
+                            query.origins.size(), query.destinations.size(),
+                            query.with_items, query.id));
             break;
         default:
             break;
@@ -109,3 +224,9 @@ svg::Document RequestHandler::RenderMap() const
 {
     return renderer_.render(catalogue_);
 }
+
+svg::Document RequestHandler::RenderIsochrone(const TransportRouter::Isochrone &_stops,
+                                              double _max_time) const
+{
+    return renderer_.renderIsochrone(catalogue_, _stops, _max_time);
+}
@@ -29,6 +29,32 @@ public:
 
     [[nodiscard]] RouteStat getRouteInfo(std::string_view _from, std::string_view _to) const;
 
+    // Маршрут в обход закрытых остановок, автобусов и перегонов
+    // и с собственными временем ожидания и скоростью
+    [[nodiscard]] RouteStat getRouteInfo(std::string_view _from, std::string_view _to,
+                                         const TransportRouter::RouteExclusions &_exclusions,
+                                         const TransportRouter::RouteProfile &_profile) const;
+
+    // Маршрут по расписаниям с отправлением не раньше _departure_time
+    [[nodiscard]] RouteStat getRouteInfo(std::string_view _from, std::string_view _to,
+                                         double _departure_time) const;
+
+    // Время в пути без состава маршрута (запрос TravelTime)
+    [[nodiscard]] std::optional<double> getTravelTime(std::string_view _from, std::string_view _to) const;
+
+    // Остановки, достижимые из _from не дольше _max_time (запрос Isochrone)
+    [[nodiscard]] TransportRouter::Isochrone getIsochrone(std::string_view _from, double _max_time) const;
+
+    // Карта изохроны поверх карты маршрутов
+    [[nodiscard]] svg::Document RenderIsochrone(const TransportRouter::Isochrone &_stops,
+                                                double _max_time) const;
+
+    // Маршруты между всеми парами остановок отправления и назначения
+    // (запрос RouteMatrix), по строке на остановку отправления
+    [[nodiscard]] TransportRouter::RouteMatrix getRouteMatrix(const std::vector<std::string_view> &_origins,
+                                                              const std::vector<std::string_view> &_destinations,
+                                                              bool _with_items) const;
+
     void procRequests(const json::Document &_doc, std::ostream &_output) const;
 
     [[nodiscard]] svg::Document RenderMap() const;
@@ -1,26 +1,62 @@
 #pragma once
 
 #include "graph.h"
+#include "thread_pool.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <stdexcept>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace graph {
 
+enum class AllPairsAlgorithm {
+    FLOYD_WARSHALL,
+    // Флойд-Уоршелл по блокам: независимые блоки каждой фазы
+    // обрабатываются параллельно. Быстрее обычного, когда релаксация
+    // строк векторизована (см. NATIVE_ARCH в CMakeLists.txt)
+    BLOCKED_FLOYD_WARSHALL,
+    // Поиск Дейкстры из каждой вершины, строки таблицы считаются параллельно
+    PARALLEL_DIJKSTRA,
+};
+
+// Сумма весов. Целочисленные веса беззнаковые, их сумма насыщается до
+// InfiniteWeight вместо переполнения: путь через отсутствующий маршрут
+// остаётся отсутствующим.
 template <typename Weight>
+constexpr Weight AddWeights(Weight lhs, Weight rhs) {
+    if constexpr (std::is_integral_v<Weight>) {
+        static_assert(std::is_unsigned_v<Weight>, "Integer weights should be unsigned");
+        const Weight sum = static_cast<Weight>(lhs + rhs);
+        return sum < lhs ? InfiniteWeight<Weight>() : sum;
+    } else {
+        return lhs + rhs;
+    }
+}
+
+// TableWeight - тип, в котором хранится таблица маршрутов между всеми парами
+// вершин. Например, для Router<double, float> таблица вдвое компактнее.
+// Целочисленный TableWeight - фиксированная точка: вес хранится в единицах
+// 1 / weight_scale с округлением, Router<double, uint32_t> с подходящей
+// единицей хранит целые веса точно.
+template <typename Weight, typename TableWeight = Weight>
 class Router {
 private:
     using Graph = DirectedWeightedGraph<Weight>;
 
 public:
-    explicit Router(const Graph& graph, bool do_initialize = true);
+    explicit Router(const Graph& graph, bool do_initialize = true,
+                    AllPairsAlgorithm algorithm = AllPairsAlgorithm::FLOYD_WARSHALL,
+                    size_t thread_count = 1, Weight weight_scale = Weight{1});
 
     struct RouteInternalData
     {
@@ -28,7 +64,40 @@ public:
         std::optional<EdgeId> prev_edge;
     };
 
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    // Таблица маршрутов между всеми парами вершин в виде двух плотных
+    // матриц (веса и последние рёбра маршрутов), строка на вершину отправления.
+    // Отсутствие маршрута и последнего ребра обозначается значениями-метками.
+    class RoutesInternalData {
+    public:
+        using CompactEdgeId = uint32_t;
+
+        static constexpr TableWeight NO_ROUTE = InfiniteWeight<TableWeight>();
+        static constexpr CompactEdgeId NO_EDGE = std::numeric_limits<CompactEdgeId>::max();
+        static constexpr size_t BYTES_PER_CELL = sizeof(TableWeight) + sizeof(CompactEdgeId);
+
+        RoutesInternalData() = default;
+        explicit RoutesInternalData(size_t vertex_count, Weight weight_scale = Weight{1});
+
+        size_t GetVertexCount() const;
+
+        // Перевод веса в значение таблицы и обратно
+        TableWeight ToTableWeight(const Weight& weight) const;
+        Weight FromTableWeight(TableWeight weight) const;
+
+        std::optional<RouteInternalData> Get(VertexId from, VertexId to) const;
+        void Set(VertexId from, VertexId to, const std::optional<RouteInternalData>& data);
+
+        TableWeight* GetWeights(VertexId from);
+        const TableWeight* GetWeights(VertexId from) const;
+        CompactEdgeId* GetPrevEdges(VertexId from);
+        const CompactEdgeId* GetPrevEdges(VertexId from) const;
+
+    private:
+        size_t vertex_count_ = 0;
+        Weight weight_scale_{1};
+        std::vector<TableWeight> weights_;
+        std::vector<CompactEdgeId> prev_edges_;
+    };
 
     struct RouteInfo {
         Weight weight;
@@ -40,101 +109,445 @@ public:
     RoutesInternalData &GetRoutesInternalData();
     const RoutesInternalData &GetRoutesInternalData() const;
 
+    // Восстановление таблицы после изменения графа: increased_edges подорожали
+    // или удалены, decreased_edges подешевели или добавлены. Заново считаются
+    // только строки, маршруты которых шли через подорожавшие рёбра, и строки
+    // начал подешевевших рёбер. Остальные строки улучшаются маршрутами через
+    // начала подешевевших рёбер: новый маршрут до первого такого ребра
+    // проходит по неизменившимся рёбрам.
+    void UpdateEdges(const std::vector<EdgeId>& increased_edges,
+                     const std::vector<EdgeId>& decreased_edges, size_t thread_count = 1);
+
 private:
+    using CompactEdgeId = typename RoutesInternalData::CompactEdgeId;
 
-    void InitializeRoutesInternalData(const Graph& graph) {
+    // Веса рёбер в типе таблицы, заодно проверка, что веса неотрицательны
+    std::vector<TableWeight> ConvertEdgeWeights() const {
+        std::vector<TableWeight> edge_weights(graph_.GetEdgeCount());
+        for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            if (graph_.IsEdgeRemoved(edge_id)) {
+                edge_weights[edge_id] = RoutesInternalData::NO_ROUTE;
+                continue;
+            }
+            edge_weights[edge_id] = routes_internal_data_.ToTableWeight(edge.weight);
+        }
+        return edge_weights;
+    }
+
+    // Проверка, что ни один маршрут не потерян из-за насыщения AddWeights.
+    // Маршрут с весом меньше NO_ROUTE считается точно: его части легче его.
+    // Веса вершин кратчайшего маршрута растут шагами не тяжелее самого
+    // тяжёлого ребра, поэтому у маршрута тяжелее NO_ROUTE нашлась бы вершина
+    // с весом между самым тяжёлым маршрутом таблицы и суммой его с этим ребром.
+    void CheckRouteWeights(const std::vector<TableWeight>& edge_weights) const {
+        if constexpr (std::is_integral_v<TableWeight>) {
+            TableWeight max_edge_weight{};
+            for (const TableWeight weight : edge_weights) {
+                if (weight != RoutesInternalData::NO_ROUTE) {
+                    max_edge_weight = std::max(max_edge_weight, weight);
+                }
+            }
+
+            const size_t vertex_count = routes_internal_data_.GetVertexCount();
+            TableWeight max_route_weight{};
+            for (VertexId from = 0; from < vertex_count; ++from) {
+                const TableWeight* const weights = routes_internal_data_.GetWeights(from);
+                for (VertexId to = 0; to < vertex_count; ++to) {
+                    if (weights[to] != RoutesInternalData::NO_ROUTE) {
+                        max_route_weight = std::max(max_route_weight, weights[to]);
+                    }
+                }
+            }
+
+            if (static_cast<uint64_t>(max_route_weight) + max_edge_weight
+                >= static_cast<uint64_t>(RoutesInternalData::NO_ROUTE)) {
+                throw std::overflow_error("Route weights do not fit the routes table");
+            }
+        }
+    }
+
+    void InitializeRoutesInternalData(const Graph& graph, const std::vector<TableWeight>& edge_weights) {
         const size_t vertex_count = graph.GetVertexCount();
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
-            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-                const auto& edge = graph.GetEdge(edge_id);
-                if (edge.weight < ZERO_WEIGHT) {
-                    throw std::domain_error("Edges' weights should be non-negative");
+            TableWeight* const weights = routes_internal_data_.GetWeights(vertex);
+            CompactEdgeId* const prev_edges = routes_internal_data_.GetPrevEdges(vertex);
+            weights[vertex] = static_cast<TableWeight>(ZERO_WEIGHT);
+            prev_edges[vertex] = RoutesInternalData::NO_EDGE;
+            graph.ForEachOutgoingEdge(vertex, [&](EdgeId edge_id, VertexId to, const Weight&) {
+                const TableWeight edge_weight = edge_weights[edge_id];
+                if (edge_weight < weights[to]) {
+                    weights[to] = edge_weight;
+                    prev_edges[to] = static_cast<CompactEdgeId>(edge_id);
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+            });
+        }
+    }
+
+    // Релаксация строки from через вершину through по столбцам [columns).
+    // Цикл не содержит ветвлений и векторизуется компилятором (min-plus над
+    // строкой): GCC с -O3 делает это для таблицы в double начиная с AVX2.
+    // Счётчик size_t: с 32-битным VertexId число итераций не вычисляется
+    // и цикл не векторизуется. Последнее ребро улучшенного маршрута всегда
+    // берётся из маршрута through -> to: при through == to или from == through
+    // улучшения не бывает.
+    static void RelaxRow(TableWeight* from_weights, CompactEdgeId* from_prev_edges,
+                         TableWeight weight_to_through,
+                         const TableWeight* through_weights, const CompactEdgeId* through_prev_edges,
+                         size_t columns_begin, size_t columns_end) {
+        for (size_t to = columns_begin; to < columns_end; ++to) {
+            const TableWeight candidate_weight = AddWeights(weight_to_through, through_weights[to]);
+            const bool is_better = candidate_weight < from_weights[to];
+            from_weights[to] = is_better ? candidate_weight : from_weights[to];
+            from_prev_edges[to] = is_better ? through_prev_edges[to] : from_prev_edges[to];
+        }
+    }
+
+    // Релаксация блока [rows) x [columns) через вершины [throughs)
+    void RelaxBlock(size_t rows_begin, size_t rows_end,
+                    size_t columns_begin, size_t columns_end,
+                    size_t throughs_begin, size_t throughs_end) {
+        for (VertexId through = throughs_begin; through < throughs_end; ++through) {
+            const TableWeight* const through_weights = routes_internal_data_.GetWeights(through);
+            const CompactEdgeId* const through_prev_edges = routes_internal_data_.GetPrevEdges(through);
+            for (VertexId from = rows_begin; from < rows_end; ++from) {
+                TableWeight* const from_weights = routes_internal_data_.GetWeights(from);
+                const TableWeight weight_to_through = from_weights[through];
+                if (weight_to_through == RoutesInternalData::NO_ROUTE) {
+                    continue;
                 }
+                RelaxRow(from_weights, routes_internal_data_.GetPrevEdges(from), weight_to_through,
+                         through_weights, through_prev_edges, columns_begin, columns_end);
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    void RelaxRoutesInternalDataBlocked(size_t thread_count) {
+        const size_t vertex_count = routes_internal_data_.GetVertexCount();
+        const size_t block_count = (vertex_count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        const auto block_begin = [](size_t block) { return block * BLOCK_SIZE; };
+        const auto block_end = [vertex_count](size_t block) {
+            return std::min(vertex_count, (block + 1) * BLOCK_SIZE);
+        };
+
+        parallel::ThreadPool pool(thread_count);
+        for (size_t phase = 0; phase < block_count; ++phase) {
+            const size_t through_begin = block_begin(phase);
+            const size_t through_end = block_end(phase);
+
+            // 1. Диагональный блок фазы
+            RelaxBlock(through_begin, through_end, through_begin, through_end,
+                       through_begin, through_end);
+
+            // 2. Блоки строки и столбца фазы зависят только от диагонального
+            pool.parallelFor(2 * block_count, [&](size_t task) {
+                const size_t block = task / 2;
+                if (block == phase) {
+                    return;
+                }
+                if (task % 2 == 0) {
+                    RelaxBlock(through_begin, through_end, block_begin(block), block_end(block),
+                               through_begin, through_end);
+                } else {
+                    RelaxBlock(block_begin(block), block_end(block), through_begin, through_end,
+                               through_begin, through_end);
+                }
+            });
+
+            // 3. Остальные блоки зависят только от блоков строки и столбца фазы
+            pool.parallelFor(block_count * block_count, [&](size_t task) {
+                const size_t row_block = task / block_count;
+                const size_t column_block = task % block_count;
+                if (row_block == phase || column_block == phase) {
+                    return;
+                }
+                RelaxBlock(block_begin(row_block), block_end(row_block),
+                           block_begin(column_block), block_end(column_block),
+                           through_begin, through_end);
+            });
         }
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
-                }
+    struct QueueEntry {
+        TableWeight weight;
+        VertexId vertex;
+
+        bool operator>(const QueueEntry& other) const {
+            return weight > other.weight;
+        }
+    };
+
+    // Строка таблицы - веса и последние рёбра маршрутов из from во все вершины
+    void ComputeRow(VertexId from, const std::vector<TableWeight>& edge_weights,
+                    std::vector<QueueEntry>& heap) {
+        TableWeight* const weights = routes_internal_data_.GetWeights(from);
+        CompactEdgeId* const prev_edges = routes_internal_data_.GetPrevEdges(from);
+
+        heap.clear();
+        heap.push_back({static_cast<TableWeight>(ZERO_WEIGHT), from});
+        weights[from] = static_cast<TableWeight>(ZERO_WEIGHT);
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<QueueEntry>{});
+            const QueueEntry entry = heap.back();
+            heap.pop_back();
+            if (weights[entry.vertex] < entry.weight) {
+                continue;
             }
+            graph_.ForEachOutgoingEdge(entry.vertex, [&](EdgeId edge_id, VertexId to, const Weight&) {
+                const TableWeight candidate_weight = AddWeights(entry.weight, edge_weights[edge_id]);
+                if (candidate_weight < weights[to]) {
+                    weights[to] = candidate_weight;
+                    prev_edges[to] = static_cast<CompactEdgeId>(edge_id);
+                    heap.push_back({candidate_weight, to});
+                    std::push_heap(heap.begin(), heap.end(), std::greater<QueueEntry>{});
+                }
+            });
         }
     }
 
+    // Строки независимы, пул раздаёт их потокам по одной по мере освобождения
+    void ComputeRoutesInternalDataByDijkstra(size_t thread_count, const std::vector<TableWeight>& edge_weights) {
+        parallel::ThreadPool pool(thread_count);
+        pool.parallelFor(routes_internal_data_.GetVertexCount(), [this, &edge_weights](size_t from) {
+            thread_local std::vector<QueueEntry> heap;
+            ComputeRow(from, edge_weights, heap);
+        });
+    }
+
+    // Три блока фазы (веса и рёбра) занимают около 600 КБ и помещаются в L2
+    static constexpr size_t BLOCK_SIZE = 128;
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
     RoutesInternalData routes_internal_data_;
 };
 
-template <typename Weight>
-Router<Weight>::Router(const Graph& graph, bool do_initialize)
+template <typename Weight, typename TableWeight>
+Router<Weight, TableWeight>::RoutesInternalData::RoutesInternalData(size_t vertex_count, Weight weight_scale)
+    : vertex_count_(vertex_count)
+    , weight_scale_(weight_scale)
+    , weights_(vertex_count * vertex_count, NO_ROUTE)
+    , prev_edges_(vertex_count * vertex_count, NO_EDGE)
+{
+}
+
+template <typename Weight, typename TableWeight>
+size_t Router<Weight, TableWeight>::RoutesInternalData::GetVertexCount() const {
+    return vertex_count_;
+}
+
+template <typename Weight, typename TableWeight>
+TableWeight Router<Weight, TableWeight>::RoutesInternalData::ToTableWeight(const Weight& weight) const {
+    if constexpr (std::is_integral_v<TableWeight>) {
+        const Weight scaled_weight = std::round(weight * weight_scale_);
+        if (!(scaled_weight < static_cast<Weight>(NO_ROUTE))) {
+            throw std::overflow_error("Weight does not fit the routes table");
+        }
+        return static_cast<TableWeight>(scaled_weight);
+    } else {
+        return static_cast<TableWeight>(weight);
+    }
+}
+
+template <typename Weight, typename TableWeight>
+Weight Router<Weight, TableWeight>::RoutesInternalData::FromTableWeight(TableWeight weight) const {
+    if constexpr (std::is_integral_v<TableWeight>) {
+        return static_cast<Weight>(weight) / weight_scale_;
+    } else {
+        return static_cast<Weight>(weight);
+    }
+}
+
+template <typename Weight, typename TableWeight>
+std::optional<typename Router<Weight, TableWeight>::RouteInternalData>
+Router<Weight, TableWeight>::RoutesInternalData::Get(VertexId from, VertexId to) const {
+    const size_t cell = from * vertex_count_ + to;
+    if (weights_.at(cell) == NO_ROUTE) {
+        return std::nullopt;
+    }
+    std::optional<EdgeId> prev_edge;
+    if (prev_edges_[cell] != NO_EDGE) {
+        prev_edge = prev_edges_[cell];
+    }
+    return RouteInternalData{FromTableWeight(weights_[cell]), prev_edge};
+}
+
+template <typename Weight, typename TableWeight>
+void Router<Weight, TableWeight>::RoutesInternalData::Set(VertexId from, VertexId to,
+                                                         const std::optional<RouteInternalData>& data) {
+    const size_t cell = from * vertex_count_ + to;
+    if (!data) {
+        weights_.at(cell) = NO_ROUTE;
+        prev_edges_[cell] = NO_EDGE;
+        return;
+    }
+    weights_.at(cell) = ToTableWeight(data->weight);
+    prev_edges_[cell] = data->prev_edge ? static_cast<CompactEdgeId>(*data->prev_edge) : NO_EDGE;
+}
+
+template <typename Weight, typename TableWeight>
+TableWeight* Router<Weight, TableWeight>::RoutesInternalData::GetWeights(VertexId from) {
+    return weights_.data() + from * vertex_count_;
+}
+
+template <typename Weight, typename TableWeight>
+const TableWeight* Router<Weight, TableWeight>::RoutesInternalData::GetWeights(VertexId from) const {
+    return weights_.data() + from * vertex_count_;
+}
+
+template <typename Weight, typename TableWeight>
+typename Router<Weight, TableWeight>::RoutesInternalData::CompactEdgeId*
+Router<Weight, TableWeight>::RoutesInternalData::GetPrevEdges(VertexId from) {
+    return prev_edges_.data() + from * vertex_count_;
+}
+
+template <typename Weight, typename TableWeight>
+const typename Router<Weight, TableWeight>::RoutesInternalData::CompactEdgeId*
+Router<Weight, TableWeight>::RoutesInternalData::GetPrevEdges(VertexId from) const {
+    return prev_edges_.data() + from * vertex_count_;
+}
+
+template <typename Weight, typename TableWeight>
+Router<Weight, TableWeight>::Router(const Graph& graph, bool do_initialize,
+                                    AllPairsAlgorithm algorithm, size_t thread_count,
+                                    Weight weight_scale)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , routes_internal_data_(graph.GetVertexCount(), weight_scale)
 {
-    if (do_initialize)
+    if (graph.GetEdgeCount() >= RoutesInternalData::NO_EDGE) {
+        throw std::length_error("Too many edges for the routes table");
+    }
+
+    if (!do_initialize)
     {
-        InitializeRoutesInternalData(graph);
+        return;
     }
 
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    const std::vector<TableWeight> edge_weights = ConvertEdgeWeights();
+    if (algorithm == AllPairsAlgorithm::PARALLEL_DIJKSTRA) {
+        ComputeRoutesInternalDataByDijkstra(thread_count, edge_weights);
+    } else {
+        InitializeRoutesInternalData(graph, edge_weights);
+
+        const size_t vertex_count = graph.GetVertexCount();
+        if (algorithm == AllPairsAlgorithm::BLOCKED_FLOYD_WARSHALL) {
+            RelaxRoutesInternalDataBlocked(thread_count);
+        } else {
+            for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+                RelaxBlock(0, vertex_count, 0, vertex_count, vertex_through, vertex_through + 1);
+            }
+        }
     }
+    CheckRouteWeights(edge_weights);
 }
 
-template <typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-                                                                             VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
+template <typename Weight, typename TableWeight>
+std::optional<typename Router<Weight, TableWeight>::RouteInfo>
+Router<Weight, TableWeight>::BuildRoute(VertexId from, VertexId to) const {
+    const auto route_internal_data = routes_internal_data_.Get(from, to);
     if (!route_internal_data) {
         return std::nullopt;
     }
     const Weight weight = route_internal_data->weight;
+    const CompactEdgeId* const prev_edges = routes_internal_data_.GetPrevEdges(from);
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    for (CompactEdgeId edge_id = prev_edges[to];
+         edge_id != RoutesInternalData::NO_EDGE;
+         edge_id = prev_edges[graph_.GetEdge(edge_id).from])
     {
-        edges.push_back(*edge_id);
+        edges.push_back(edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
     return RouteInfo{weight, std::move(edges)};
 }
 
-template<typename Weight>
-typename Router<Weight>::RoutesInternalData &
-Router<Weight>::GetRoutesInternalData()
+template <typename Weight, typename TableWeight>
+typename Router<Weight, TableWeight>::RoutesInternalData &
+Router<Weight, TableWeight>::GetRoutesInternalData()
 {
     return routes_internal_data_;
 }
 
-template<typename Weight>
-const typename Router<Weight>::RoutesInternalData &
-Router<Weight>::GetRoutesInternalData() const
+template <typename Weight, typename TableWeight>
+const typename Router<Weight, TableWeight>::RoutesInternalData &
+Router<Weight, TableWeight>::GetRoutesInternalData() const
 {
     return routes_internal_data_;
 }
 
+template <typename Weight, typename TableWeight>
+void Router<Weight, TableWeight>::UpdateEdges(const std::vector<EdgeId>& increased_edges,
+                                              const std::vector<EdgeId>& decreased_edges,
+                                              size_t thread_count) {
+    if (graph_.GetEdgeCount() >= RoutesInternalData::NO_EDGE) {
+        throw std::length_error("Too many edges for the routes table");
+    }
+
+    const std::vector<TableWeight> edge_weights = ConvertEdgeWeights();
+    const size_t vertex_count = routes_internal_data_.GetVertexCount();
+
+    // Флаги пишутся из разных потоков, поэтому не vector<bool>
+    std::vector<char> is_recomputed(vertex_count, 0);
+    std::vector<VertexId> sources;
+    for (const EdgeId edge_id : decreased_edges) {
+        const VertexId from = graph_.GetEdge(edge_id).from;
+        if (!is_recomputed[from]) {
+            is_recomputed[from] = 1;
+            sources.push_back(from);
+        }
+    }
+
+    parallel::ThreadPool pool(thread_count);
+
+    // Ребро входит в дерево маршрутов строки, только если оно последнее
+    // в маршруте до своего конца
+    pool.parallelFor(vertex_count, [&](size_t from) {
+        const CompactEdgeId* const prev_edges = routes_internal_data_.GetPrevEdges(from);
+        for (const EdgeId edge_id : increased_edges) {
+            if (prev_edges[graph_.GetEdge(edge_id).to] == edge_id) {
+                is_recomputed[from] = 1;
+                return;
+            }
+        }
+    });
+
+    pool.parallelFor(vertex_count, [&](size_t from) {
+        if (!is_recomputed[from]) {
+            return;
+        }
+        TableWeight* const weights = routes_internal_data_.GetWeights(from);
+        CompactEdgeId* const prev_edges = routes_internal_data_.GetPrevEdges(from);
+        std::fill(weights, weights + vertex_count, RoutesInternalData::NO_ROUTE);
+        std::fill(prev_edges, prev_edges + vertex_count, RoutesInternalData::NO_EDGE);
+
+        thread_local std::vector<QueueEntry> heap;
+        ComputeRow(from, edge_weights, heap);
+    });
+
+    if (!sources.empty()) {
+        // Посчитанные заново строки уже точны и только читаются
+        pool.parallelFor(vertex_count, [&](size_t from) {
+            if (is_recomputed[from]) {
+                return;
+            }
+            TableWeight* const from_weights = routes_internal_data_.GetWeights(from);
+            CompactEdgeId* const from_prev_edges = routes_internal_data_.GetPrevEdges(from);
+            for (const VertexId source : sources) {
+                const TableWeight weight_to_source = from_weights[source];
+                if (weight_to_source == RoutesInternalData::NO_ROUTE) {
+                    continue;
+                }
+                RelaxRow(from_weights, from_prev_edges, weight_to_source,
+                         routes_internal_data_.GetWeights(source), routes_internal_data_.GetPrevEdges(source),
+                         0, vertex_count);
+            }
+        });
+    }
+
+    CheckRouteWeights(edge_weights);
+}
+
 }  // namespace graph
@@ -49,6 +49,15 @@ bool Serialization::Deserialize(TransportCatalogue &catalogue,
     ParseRenderSettingsFromProto(render);
 
     ParseTransportRouterFromProto(router);
+    if (router.getRouterMode() == TransportRouter::RouterMode::RAPTOR)
+    {
+        // Данные RAPTOR линейны по размеру справочника и в базу не пишутся
+        router.createGraph(catalogue);
+    }
+    // Индекс автобусов и соединения расписаний строятся по справочнику
+    // и в базу не пишутся
+    router.createBusIndex(catalogue);
+    router.createTimetable(catalogue);
     return true;
 }
 
@@ -99,6 +108,10 @@ void Serialization::AddRoutesInProto(const TransportCatalogue &catalogue)
         proto_transport_catalogue::Route proto_route;
         proto_route.set_name(route.name_.data());
         proto_route.set_is_circul(route.is_circul_);
+        for (const double departure : route.departures_)
+        {
+            proto_route.add_departures(departure);
+        }
 
         for (const auto &stop : route.route_)
         {
@@ -122,6 +135,7 @@ void Serialization::ParseRoutesFromProto(TransportCatalogue &catalogue)
         {
             new_bus.route_.emplace_back(stop_name_by_id_.at(stop));
         }
+        new_bus.departures_.assign(it->departures().begin(), it->departures().end());
 
         catalogue.addBus(std::move(new_bus));
     }
@@ -281,6 +295,19 @@ void Serialization::AddTransportRouterSettingsInProto(const TransportRouter &rou
 
     proto_settings->set_wait_time(wait_time);
     proto_settings->set_velocity(velocity);
+    proto_settings->set_router_mode(
+                static_cast<proto_transport_router::RouterMode>(router.getRouterMode()));
+    proto_settings->set_all_pairs_algorithm(
+                static_cast<proto_transport_router::AllPairsAlgorithm>(router.getAllPairsAlgorithm()));
+    proto_settings->set_build_threads(router.getBuildThreads());
+    proto_settings->set_landmark_count(router.getLandmarkCount());
+    proto_settings->set_row_cache_bytes(router.getRowCacheBytes());
+    proto_settings->set_table_weight_format(
+                static_cast<proto_transport_router::TableWeightFormat>(router.getTableWeightFormat()));
+    proto_settings->set_graph_model(
+                static_cast<proto_transport_router::GraphModel>(router.getGraphModel()));
+    *proto_settings->mutable_overlay_cell_sizes() = {router.getOverlayCellSizes().begin(),
+                                                     router.getOverlayCellSizes().end()};
 }
 
 void Serialization::ParseTransportRouterSettingsFromProto(TransportRouter &router) const
@@ -288,7 +315,17 @@ void Serialization::ParseTransportRouterSettingsFromProto(TransportRouter &route
     const auto &proto_settings = proto_catalogue_.router().settings();
 
     router.setWaitTime(proto_settings.wait_time()).
-            setVelocity(proto_settings.velocity()).
+            setVelocityInMetersPerMinute(proto_settings.velocity()).
+            setRouterMode(static_cast<TransportRouter::RouterMode>(proto_settings.router_mode())).
+            setAllPairsAlgorithm(static_cast<graph::AllPairsAlgorithm>(proto_settings.all_pairs_algorithm())).
+            setBuildThreads(proto_settings.build_threads()).
+            setLandmarkCount(proto_settings.landmark_count()).
+            setRowCacheBytes(proto_settings.row_cache_bytes()).
+            setTableWeightFormat(static_cast<TransportRouter::TableWeightFormat>(
+                                     proto_settings.table_weight_format())).
+            setGraphModel(static_cast<TransportRouter::GraphModel>(proto_settings.graph_model())).
+            setOverlayCellSizes({proto_settings.overlay_cell_sizes().begin(),
+                                 proto_settings.overlay_cell_sizes().end()}).
             setInitSetting(true);
 }
 
@@ -297,33 +334,42 @@ void Serialization::AddTransportRouterInProto(const TransportRouter &router)
     AddTransportRouterSettingsInProto(router);
     AddGraphInProto(router);
     AddInternalRouterInProto(router);
+    AddContractionHierarchyInProto(router);
+    AddGeoPotentialInProto(router);
+    AddLandmarksInProto(router);
+    AddHubLabelsInProto(router);
+    AddOverlayInProto(router);
 
     auto *proto_vertexes = proto_catalogue_.mutable_router()->mutable_vertexes();
     for (const auto &[stop_name, id_vertex] : router.getVertexes())
     {
         proto_transport_router::VertexIds proto;
-        proto.set_waiting(id_vertex.waiting);
-        proto.set_moving(id_vertex.moving);
+        proto.set_waiting(static_cast<uint32_t>(id_vertex.waiting));
+        proto.set_moving(static_cast<uint32_t>(id_vertex.moving));
+        proto.set_stop(id_vertex.stop);
         (*proto_vertexes)[stop_id_by_name_.at(stop_name)] = std::move(proto);
     }
 
-    auto *proto_wait_edges = proto_catalogue_.mutable_router()->mutable_wait_edges();
-    for (const auto &[id_edge, wait_info] : router.getWaitEdges())
+    auto *proto_router = proto_catalogue_.mutable_router();
+    for (const auto stop_name : router.getStopNames())
     {
-        proto_transport_router::WaitInfo proto;
-        proto.set_stop_id(stop_id_by_name_.at(wait_info.name));
-        proto.set_time(wait_info.time);
-        (*proto_wait_edges)[id_edge] = std::move(proto);
+        proto_router->add_stop_ids(stop_id_by_name_.at(stop_name));
     }
 
-    auto *proto_bus_edges = proto_catalogue_.mutable_router()->mutable_bus_edges();
-    for (const auto &[id_edge, route_info] : router.getBusEdges())
+    for (const auto bus_name : router.getBusNames())
     {
-        proto_transport_router::BusRouteInfo proto;
-        proto.set_name(route_info.name.data());
-        proto.set_span_count(route_info.span_count);
-        proto.set_time(route_info.time);
-        (*proto_bus_edges)[id_edge] = std::move(proto);
+        proto_router->add_bus_names(bus_name.data(), bus_name.size());
+    }
+
+    for (const auto &edge_info : router.getEdgesInfo())
+    {
+        auto *proto = proto_router->add_edges_info();
+        proto->set_kind(static_cast<proto_transport_router::EdgeKind>(edge_info.kind));
+        proto->set_stop(edge_info.stop);
+        proto->set_bus(edge_info.bus);
+        proto->set_span_count(edge_info.span_count);
+        proto->set_time(edge_info.time);
+        proto->set_position(edge_info.position);
     }
 }
 
@@ -331,6 +377,7 @@ void Serialization::ParseTransportRouterFromProto(TransportRouter &router)
 {
     ParseTransportRouterSettingsFromProto(router);
     ParseGraphFromProto(router);
+    ParseGeoPotentialFromProto(router);
 
     const auto &proto_vertexes = proto_catalogue_.router().vertexes();
     auto &router_vertexes = router.getVertexes();
@@ -338,23 +385,34 @@ void Serialization::ParseTransportRouterFromProto(TransportRouter &router)
     {
         router_vertexes[stop_name_by_id_.at(id_stop)].moving = id_vertex.moving();
         router_vertexes[stop_name_by_id_.at(id_stop)].waiting = id_vertex.waiting();
+        router_vertexes[stop_name_by_id_.at(id_stop)].stop = id_vertex.stop();
+    }
+
+    const auto &proto_router = proto_catalogue_.router();
+    auto &router_stop_names = router.getStopNames();
+    router_stop_names.reserve(proto_router.stop_ids_size());
+    for (const auto stop_id : proto_router.stop_ids())
+    {
+        router_stop_names.push_back(stop_name_by_id_.at(stop_id));
     }
 
-    const auto &proto_wait_edges = proto_catalogue_.router().wait_edges();
-    auto &router_wait_edges = router.getWaitEdges();
-    for (const auto &[id_edge, wait_info] : proto_wait_edges)
+    auto &router_bus_names = router.getBusNames();
+    router_bus_names.reserve(proto_router.bus_names_size());
+    for (const auto &bus_name : proto_router.bus_names())
     {
-        router_wait_edges[id_edge].name = stop_name_by_id_.at(wait_info.stop_id());
-        router_wait_edges[id_edge].time = wait_info.time();
+        router_bus_names.push_back(bus_name);
     }
 
-    const auto &proto_bus_edges = proto_catalogue_.router().bus_edges();
-    auto &router_bus_edges = router.getBusEdges();
-    for (const auto &[id_edge, route_info] : proto_bus_edges)
+    auto &router_edges_info = router.getEdgesInfo();
+    router_edges_info.reserve(proto_router.edges_info_size());
+    for (const auto &edge_info : proto_router.edges_info())
     {
-        router_bus_edges[id_edge].name = route_info.name();
-        router_bus_edges[id_edge].span_count = route_info.span_count();
-        router_bus_edges[id_edge].time = route_info.time();
+        router_edges_info.push_back({static_cast<TransportRouter::EdgeKind>(edge_info.kind()),
+                                     edge_info.stop(),
+                                     edge_info.bus(),
+                                     edge_info.span_count(),
+                                     edge_info.time(),
+                                     edge_info.position()});
     }
 }
 
@@ -363,16 +421,19 @@ void Serialization::AddGraphInProto(const TransportRouter &router)
     auto *p_graph = proto_catalogue_.mutable_router()->mutable_graph();
     const auto &graph = router.getGraph();
 
+    // Номера в базе 32-битные, Freeze() уже проверил, что граф в них помещается
+    p_graph->mutable_edges()->Reserve(static_cast<int>(graph.GetEdgeCount()));
     for (size_t edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id)
     {
+        const auto &edge = graph.GetEdge(static_cast<graph::EdgeId>(edge_id));
         proto_graph::Edge p_edge;
-        p_edge.set_from(graph.GetEdge(edge_id).from);
-        p_edge.set_to(graph.GetEdge(edge_id).to);
-        p_edge.set_weight(graph.GetEdge(edge_id).weight);
+        p_edge.set_from(static_cast<uint32_t>(edge.from));
+        p_edge.set_to(static_cast<uint32_t>(edge.to));
+        p_edge.set_weight(edge.weight);
         *p_graph->add_edges() = std::move(p_edge);
     }
 
-    p_graph->set_vertex_count(graph.GetVertexCount());
+    p_graph->set_vertex_count(static_cast<uint32_t>(graph.GetVertexCount()));
 }
 
 void Serialization::ParseGraphFromProto(TransportRouter &router)
@@ -388,21 +449,30 @@ void Serialization::ParseGraphFromProto(TransportRouter &router)
     for (auto edge_id = 0; edge_id < p_graph.edges_size(); ++edge_id)
     {
         const auto &p_edge = p_graph.edges(edge_id);
-        graph.AddEdge({p_edge.from(), p_edge.to(), p_edge.weight()});
+        const graph::EdgeId id = graph.AddEdge({p_edge.from(), p_edge.to(), p_edge.weight()});
+        // Удалённые при обновлении автобусов рёбра хранятся с бесконечным весом
+        if (p_edge.weight() == graph::InfiniteWeight<double>())
+        {
+            graph.RemoveEdge(id);
+        }
     }
+    graph.Freeze();
 
     ParseInternalRouterFromProto(router);
 }
 
-void Serialization::AddInternalRouterInProto(const TransportRouter &router)
+// Таблица маршрутов пишется в базу в весах графа независимо от типа весов таблицы
+template <typename Router>
+void addRoutesInternalDataInProto(const Router &router, proto_graph::Router &proto_router)
 {
-    auto *proto_router = proto_catalogue_.mutable_router()->mutable_router();
-
-    for (const auto &data : router.getInternalRouter()->GetRoutesInternalData())
+    const auto &routes_internal_data = router.GetRoutesInternalData();
+    const size_t vertex_count = routes_internal_data.GetVertexCount();
+    for (graph::VertexId from = 0; from < vertex_count; ++from)
     {
         proto_graph::RoutesInternalData proto_data;
-        for (const auto &internal : data)
+        for (graph::VertexId to = 0; to < vertex_count; ++to)
         {
+            const auto internal = routes_internal_data.Get(from, to);
             proto_graph::OptionalRouteInternalData proto_internal;
             if (internal.has_value())
             {
@@ -416,18 +486,14 @@ void Serialization::AddInternalRouterInProto(const TransportRouter &router)
             }
             *proto_data.add_routes_internal_data() = std::move(proto_internal);
         }
-        *proto_router->add_routes_internal_data() = std::move(proto_data);
+        *proto_router.add_routes_internal_data() = std::move(proto_data);
     }
 }
 
-void Serialization::ParseInternalRouterFromProto(TransportRouter &router)
+template <typename Router>
+void parseRoutesInternalDataFromProto(const proto_graph::Router &proto_router, Router &router)
 {
-    const auto &proto_router = proto_catalogue_.router().router();
-
-    router.setRouterWithNewGraph();
-
-    auto &routes_internal_data = router.getInternalRouter()->GetRoutesInternalData();
-
+    auto &routes_internal_data = router.GetRoutesInternalData();
     for (int index = 0; index < proto_router.routes_internal_data_size(); ++index)
     {
         const auto &proto_internal_data = proto_router.routes_internal_data(index);
@@ -438,7 +504,7 @@ void Serialization::ParseInternalRouterFromProto(TransportRouter &router)
             if ( proto_optional_data.optional_route_internal_data_case() ==
                  proto_graph::OptionalRouteInternalData::kRouteInternalData )
             {
-                graph::Router<double>::RouteInternalData data;
+                typename Router::RouteInternalData data;
                 const auto &proto_data = proto_optional_data.route_internal_data();
                 data.weight = proto_data.weight();
                 if ( proto_data.optional_prev_edge_case() ==
@@ -450,14 +516,251 @@ void Serialization::ParseInternalRouterFromProto(TransportRouter &router)
                 {
                     data.prev_edge = std::nullopt;
                 }
-                routes_internal_data[index][ind] = data;
+                routes_internal_data.Set(index, ind, data);
             }
             else
             {
-                routes_internal_data[index][ind] = std::nullopt;
+                routes_internal_data.Set(index, ind, std::nullopt);
             }
         }
     }
 }
 
+void Serialization::AddInternalRouterInProto(const TransportRouter &router)
+{
+    if (router.getInternalRouter() != nullptr)
+    {
+        addRoutesInternalDataInProto(*router.getInternalRouter(),
+                                     *proto_catalogue_.mutable_router()->mutable_router());
+    }
+    else if (router.getFixedPointRouter() != nullptr)
+    {
+        addRoutesInternalDataInProto(*router.getFixedPointRouter(),
+                                     *proto_catalogue_.mutable_router()->mutable_router());
+    }
+}
+
+void Serialization::ParseInternalRouterFromProto(TransportRouter &router)
+{
+    const auto &proto_router = proto_catalogue_.router().router();
+
+    router.setRouterWithNewGraph(false);
+    ParseContractionHierarchyFromProto(router);
+    ParseLandmarksFromProto(router);
+    ParseHubLabelsFromProto(router);
+    ParseOverlayFromProto(router);
+
+    if (router.getInternalRouter() != nullptr)
+    {
+        parseRoutesInternalDataFromProto(proto_router, *router.getInternalRouter());
+    }
+    else if (router.getFixedPointRouter() != nullptr)
+    {
+        parseRoutesInternalDataFromProto(proto_router, *router.getFixedPointRouter());
+    }
+}
+
+void Serialization::AddContractionHierarchyInProto(const TransportRouter &router)
+{
+    const auto *hierarchy = router.getContractionHierarchy();
+    if (hierarchy == nullptr)
+    {
+        return;
+    }
+
+    auto *proto_hierarchy = proto_catalogue_.mutable_router()->mutable_contraction_hierarchy();
+    for (const auto rank : hierarchy->GetRanks())
+    {
+        proto_hierarchy->add_ranks(rank);
+    }
+
+    for (const auto &shortcut : hierarchy->GetShortcuts())
+    {
+        auto *proto_shortcut = proto_hierarchy->add_shortcuts();
+        proto_shortcut->set_from(shortcut.from);
+        proto_shortcut->set_to(shortcut.to);
+        proto_shortcut->set_weight(shortcut.weight);
+        proto_shortcut->set_first_arc(shortcut.first_arc);
+        proto_shortcut->set_second_arc(shortcut.second_arc);
+    }
+}
+
+void Serialization::ParseContractionHierarchyFromProto(TransportRouter &router)
+{
+    if (router.getRouterMode() != TransportRouter::RouterMode::CONTRACTION_HIERARCHY)
+    {
+        return;
+    }
+
+    const auto &proto_hierarchy = proto_catalogue_.router().contraction_hierarchy();
+
+    std::vector<uint32_t> ranks(proto_hierarchy.ranks().begin(), proto_hierarchy.ranks().end());
+
+    std::vector<graph::ContractionHierarchy<double>::Shortcut> shortcuts;
+    shortcuts.reserve(proto_hierarchy.shortcuts_size());
+    for (const auto &proto_shortcut : proto_hierarchy.shortcuts())
+    {
+        shortcuts.push_back({proto_shortcut.from(), proto_shortcut.to(), proto_shortcut.weight(),
+                             proto_shortcut.first_arc(), proto_shortcut.second_arc()});
+    }
+
+    router.loadContractionHierarchy(std::move(ranks), std::move(shortcuts));
+}
+
+void Serialization::AddGeoPotentialInProto(const TransportRouter &router)
+{
+    const auto &coordinates = router.getVertexCoordinates();
+    if (coordinates.empty())
+    {
+        return;
+    }
+
+    auto *proto_potential = proto_catalogue_.mutable_router()->mutable_geo_potential();
+    for (const auto &point : coordinates)
+    {
+        proto_potential->add_latitudes(point.lat);
+        proto_potential->add_longitudes(point.lng);
+    }
+    proto_potential->set_min_time_per_meter(router.getMinTimePerMeter());
+}
+
+void Serialization::ParseGeoPotentialFromProto(TransportRouter &router) const
+{
+    const auto &proto_potential = proto_catalogue_.router().geo_potential();
+
+    auto &coordinates = router.getVertexCoordinates();
+    coordinates.reserve(proto_potential.latitudes_size());
+    for (int index = 0; index < proto_potential.latitudes_size(); ++index)
+    {
+        coordinates.push_back({proto_potential.latitudes(index), proto_potential.longitudes(index)});
+    }
+    router.setMinTimePerMeter(proto_potential.min_time_per_meter());
+}
+
+void Serialization::AddLandmarksInProto(const TransportRouter &router)
+{
+    const auto *landmarks = router.getLandmarks();
+    if (landmarks == nullptr)
+    {
+        return;
+    }
+
+    auto *proto_landmarks = proto_catalogue_.mutable_router()->mutable_landmarks();
+    for (const auto landmark : landmarks->GetLandmarks())
+    {
+        proto_landmarks->add_landmarks(landmark);
+    }
+    *proto_landmarks->mutable_distances_from() = {landmarks->GetDistancesFrom().begin(),
+                                                  landmarks->GetDistancesFrom().end()};
+    *proto_landmarks->mutable_distances_to() = {landmarks->GetDistancesTo().begin(),
+                                                landmarks->GetDistancesTo().end()};
+}
+
+void Serialization::ParseLandmarksFromProto(TransportRouter &router) const
+{
+    if (router.getRouterMode() != TransportRouter::RouterMode::ALT)
+    {
+        return;
+    }
+
+    const auto &proto_landmarks = proto_catalogue_.router().landmarks();
+    router.loadLandmarks({proto_landmarks.landmarks().begin(), proto_landmarks.landmarks().end()},
+                         {proto_landmarks.distances_from().begin(), proto_landmarks.distances_from().end()},
+                         {proto_landmarks.distances_to().begin(), proto_landmarks.distances_to().end()});
+}
+
+proto_graph::HubLabel makeProtoHubLabel(const graph::HubLabels<double>::Labels &labels)
+{
+    proto_graph::HubLabel result;
+    *result.mutable_offsets() = {labels.offsets.begin(), labels.offsets.end()};
+    result.mutable_hubs()->Reserve(labels.entries.size());
+    result.mutable_weights()->Reserve(labels.entries.size());
+    for (const auto &entry : labels.entries)
+    {
+        result.add_hubs(entry.hub);
+        result.add_weights(entry.weight);
+    }
+    return result;
+}
+
+graph::HubLabels<double>::Labels makeHubLabels(const proto_graph::HubLabel &proto_labels)
+{
+    graph::HubLabels<double>::Labels result;
+    result.offsets.assign(proto_labels.offsets().begin(), proto_labels.offsets().end());
+    result.entries.reserve(proto_labels.hubs_size());
+    for (int index = 0; index < proto_labels.hubs_size(); ++index)
+    {
+        result.entries.push_back({proto_labels.hubs(index), proto_labels.weights(index)});
+    }
+    return result;
+}
+
+void Serialization::AddHubLabelsInProto(const TransportRouter &router)
+{
+    const auto *hub_labels = router.getHubLabels();
+    if (hub_labels == nullptr)
+    {
+        return;
+    }
+
+    auto *proto_hub_labels = proto_catalogue_.mutable_router()->mutable_hub_labels();
+    *proto_hub_labels->mutable_out_labels() = makeProtoHubLabel(hub_labels->GetOutLabels());
+    *proto_hub_labels->mutable_in_labels() = makeProtoHubLabel(hub_labels->GetInLabels());
+}
+
+void Serialization::ParseHubLabelsFromProto(TransportRouter &router) const
+{
+    if (router.getRouterMode() != TransportRouter::RouterMode::HUB_LABELS)
+    {
+        return;
+    }
+
+    const auto &proto_hub_labels = proto_catalogue_.router().hub_labels();
+    router.loadHubLabels(makeHubLabels(proto_hub_labels.out_labels()),
+                         makeHubLabels(proto_hub_labels.in_labels()));
+}
+
+void Serialization::AddOverlayInProto(const TransportRouter &router)
+{
+    const auto *overlay = router.getOverlay();
+    if (overlay == nullptr)
+    {
+        return;
+    }
+
+    auto *proto_overlay = proto_catalogue_.mutable_router()->mutable_overlay();
+    const auto &partition = overlay->GetPartition();
+    const auto cliques = overlay->GetCliques();
+    for (size_t level = 0; level < partition.size(); ++level)
+    {
+        auto *proto_level = proto_overlay->add_levels();
+        *proto_level->mutable_cells() = {partition[level].begin(), partition[level].end()};
+        *proto_level->mutable_arc_counts() = {cliques[level].arc_counts.begin(),
+                                              cliques[level].arc_counts.end()};
+        *proto_level->mutable_arc_targets() = {cliques[level].targets.begin(),
+                                               cliques[level].targets.end()};
+        *proto_level->mutable_arc_weights() = {cliques[level].weights.begin(),
+                                               cliques[level].weights.end()};
+    }
+}
+
+void Serialization::ParseOverlayFromProto(TransportRouter &router) const
+{
+    if (router.getRouterMode() != TransportRouter::RouterMode::OVERLAY)
+    {
+        return;
+    }
+
+    graph::MultilevelOverlay<double>::Partition partition;
+    std::vector<graph::MultilevelOverlay<double>::Cliques> cliques;
+    for (const auto &proto_level : proto_catalogue_.router().overlay().levels())
+    {
+        partition.emplace_back(proto_level.cells().begin(), proto_level.cells().end());
+        cliques.push_back({{proto_level.arc_counts().begin(), proto_level.arc_counts().end()},
+                           {proto_level.arc_targets().begin(), proto_level.arc_targets().end()},
+                           {proto_level.arc_weights().begin(), proto_level.arc_weights().end()}});
+    }
+    router.loadOverlay(std::move(partition), cliques);
+}
+
 } // namespace serialization
@@ -51,6 +51,21 @@ private:
     void AddInternalRouterInProto(const TransportRouter &router);
     void ParseInternalRouterFromProto(TransportRouter &router);
 
+    void AddContractionHierarchyInProto(const TransportRouter &router);
+    void ParseContractionHierarchyFromProto(TransportRouter &router);
+
+    void AddGeoPotentialInProto(const TransportRouter &router);
+    void ParseGeoPotentialFromProto(TransportRouter &router) const;
+
+    void AddLandmarksInProto(const TransportRouter &router);
+    void ParseLandmarksFromProto(TransportRouter &router) const;
+
+    void AddHubLabelsInProto(const TransportRouter &router);
+    void ParseHubLabelsFromProto(TransportRouter &router) const;
+
+    void AddOverlayInProto(const TransportRouter &router);
+    void ParseOverlayFromProto(TransportRouter &router) const;
+
     std::filesystem::path path_;
 
     ProtoTransportCatalogue proto_catalogue_;
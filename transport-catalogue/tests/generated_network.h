@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "libs/geo.h"
+#include "libs/json.h"
+
+namespace generated
+{
+
+struct NetworkShape
+{
+    size_t stop_count = 1200;
+    size_t bus_count = 200;
+    // Наибольшее число остановок в маршруте автобуса
+    size_t max_bus_stops = 31;
+    uint32_t seed = 1;
+};
+
+// Запрос make_base со случайной сетью: остановки в прямоугольнике около
+// Москвы, автобусы по случайным остановкам, 40% кольцевых. Расстояние по
+// дороге в 1.1-2 раза длиннее расстояния по прямой, у некольцевого автобуса
+// обратное расстояние задано в половине перегонов
+inline json::Document generateNetwork(const NetworkShape &_shape, json::Dict _routing_settings)
+{
+    std::mt19937 random(_shape.seed);
+    const auto uniform = [&random](double _from, double _to)
+    {
+        return std::uniform_real_distribution<double>(_from, _to)(random);
+    };
+    const auto stopName = [](size_t _stop)
+    {
+        return "S" + std::to_string(_stop);
+    };
+
+    std::vector<geo::Coordinates> coordinates(_shape.stop_count);
+    for (auto &stop : coordinates)
+    {
+        stop.lat = 55.5 + uniform(0.0, 0.3);
+        stop.lng = 37.4 + uniform(0.0, 0.4);
+    }
+
+    std::map<std::pair<size_t, size_t>, int> distances;
+    const auto setDistance = [&](size_t _from, size_t _to)
+    {
+        const double distance = geo::ComputeDistance(coordinates[_from], coordinates[_to]);
+        distances.emplace(std::make_pair(_from, _to), static_cast<int>(distance * uniform(1.1, 2.0)) + 1);
+    };
+
+    json::Array base_requests;
+    std::vector<json::Node> buses;
+    std::uniform_int_distribution<size_t> random_stop(0, _shape.stop_count - 1);
+    for (size_t bus = 0; bus < _shape.bus_count; ++bus)
+    {
+        const size_t stop_count = std::uniform_int_distribution<size_t>(2, _shape.max_bus_stops)(random);
+        std::vector<size_t> route{random_stop(random)};
+        while (route.size() < stop_count)
+        {
+            const size_t stop = random_stop(random);
+            if (stop != route.back())
+            {
+                route.push_back(stop);
+            }
+        }
+        const bool is_roundtrip = uniform(0.0, 1.0) < 0.4;
+        if (is_roundtrip && route.front() != route.back())
+        {
+            route.push_back(route.front());
+        }
+
+        json::Array stops;
+        for (size_t index = 0; index < route.size(); ++index)
+        {
+            stops.emplace_back(stopName(route[index]));
+            if (index == 0)
+            {
+                continue;
+            }
+            setDistance(route[index - 1], route[index]);
+            if (!is_roundtrip && uniform(0.0, 1.0) < 0.5)
+            {
+                setDistance(route[index], route[index - 1]);
+            }
+        }
+        buses.emplace_back(json::Dict{{"type", std::string("Bus")},
+                                      {"name", "B" + std::to_string(bus)},
+                                      {"stops", std::move(stops)},
+                                      {"is_roundtrip", is_roundtrip}});
+    }
+
+    std::vector<json::Dict> road_distances(_shape.stop_count);
+    for (const auto &[stops, distance] : distances)
+    {
+        road_distances[stops.first].emplace(stopName(stops.second), distance);
+    }
+    for (size_t stop = 0; stop < _shape.stop_count; ++stop)
+    {
+        base_requests.emplace_back(json::Dict{{"type", std::string("Stop")},
+                                              {"name", stopName(stop)},
+                                              {"latitude", coordinates[stop].lat},
+                                              {"longitude", coordinates[stop].lng},
+                                              {"road_distances", std::move(road_distances[stop])}});
+    }
+    for (auto &bus : buses)
+    {
+        base_requests.push_back(std::move(bus));
+    }
+
+    return json::Document(json::Dict{{"base_requests", std::move(base_requests)},
+                                     {"routing_settings", std::move(_routing_settings)}});
+}
+
+} // namespace generated
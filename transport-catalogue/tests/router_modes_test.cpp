@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "generated_network.h"
+#include "json_reader.h"
+#include "serialization.h"
+
+namespace
+{
+
+using Queries = std::vector<std::pair<std::string, std::string>>;
+using RouteTimes = std::vector<std::optional<double>>;
+
+const generated::NetworkShape SHAPE{150, 30, 12, 7};
+
+const size_t QUERY_COUNT = 300;
+
+struct Settings
+{
+    std::string name;
+    json::Dict routing_settings;
+};
+
+// База строится и читается как в make_base и process_requests. Пустой
+// _queries заполняется случайными парами остановок с вершинами в графе
+RouteTimes computeRouteTimes(const json::Dict &_routing_settings, Queries &_queries, int &_failures)
+{
+    const std::filesystem::path path = "router_modes_test.db";
+    {
+        const json::Document doc = generated::generateNetwork(SHAPE, _routing_settings);
+        TransportCatalogue catalogue;
+        renderer::MapRenderer render;
+        TransportRouter router;
+        reader::JsonReader reader(catalogue, render, router);
+        reader.parseBaseRequests(doc);
+        reader.parseRoutingSettings(doc);
+        router.createGraph(catalogue);
+        serialization::Serialization(path).Serialize(catalogue, render, router);
+    }
+
+    TransportCatalogue catalogue;
+    renderer::MapRenderer render;
+    TransportRouter router;
+    serialization::Serialization serialization(path);
+    serialization.Deserialize(catalogue, render, router);
+
+    if (_queries.empty())
+    {
+        const std::vector<const domain::Stop *> stops = catalogue.getSortedUsedStops();
+        std::mt19937 random(SHAPE.seed);
+        std::uniform_int_distribution<size_t> random_stop(0, stops.size() - 1);
+        for (size_t query = 0; query < QUERY_COUNT; ++query)
+        {
+            _queries.emplace_back(stops[random_stop(random)]->name_, stops[random_stop(random)]->name_);
+        }
+    }
+
+    RouteTimes times;
+    for (const auto &[from, to] : _queries)
+    {
+        const auto route = router.buildRoute(from, to);
+        if (!route.has_value())
+        {
+            times.emplace_back();
+            continue;
+        }
+
+        double items_time = 0.0;
+        for (const auto &item : route->second)
+        {
+            if (const auto *wait = std::get_if<domain::WaitInfo>(&item))
+            {
+                items_time += wait->time;
+            }
+            else if (const auto *bus = std::get_if<domain::BusRouteInfo>(&item))
+            {
+                items_time += bus->time;
+            }
+        }
+        if (std::abs(items_time - route->first) > 1e-6 * std::max(1.0, route->first))
+        {
+            std::cerr << "route " << from << " -> " << to << ": items take " << items_time
+                      << " of " << route->first << '\n';
+            ++_failures;
+        }
+        times.push_back(route->first);
+    }
+    std::filesystem::remove(path);
+    return times;
+}
+
+std::vector<Settings> makeSettings()
+{
+    const auto routing = [](std::string _mode, std::string _model)
+    {
+        return json::Dict{{"bus_wait_time", 6}, {"bus_velocity", 30},
+                          {"router_mode", std::move(_mode)}, {"graph_model", std::move(_model)}};
+    };
+
+    std::vector<Settings> settings;
+    for (const std::string model : {"stop_pairs", "merged_stops", "line"})
+    {
+        for (const std::string algorithm : {"floyd_warshall", "blocked_floyd_warshall", "parallel_dijkstra"})
+        {
+            json::Dict dict = routing("precompute", model);
+            dict.emplace("all_pairs_algorithm", algorithm);
+            dict.emplace("build_threads", 2);
+            settings.push_back({"precompute " + algorithm + ' ' + model, std::move(dict)});
+        }
+        json::Dict fixed_point = routing("precompute", model);
+        fixed_point.emplace("table_weight", std::string("fixed_point"));
+        settings.push_back({"precompute fixed_point " + model, std::move(fixed_point)});
+
+        for (const std::string mode : {"on_demand", "contraction_hierarchy", "a_star", "alt",
+             "hub_labels", "lazy", "overlay"})
+        {
+            settings.push_back({mode + ' ' + model, routing(mode, model)});
+        }
+    }
+    settings.push_back({"raptor", routing("raptor", "stop_pairs")});
+    return settings;
+}
+
+} // namespace
+
+// Время маршрутов во всех режимах маршрутизатора и моделях графа
+// совпадает с поиском Дейкстры по модели STOP_PAIRS
+int main()
+{
+    int failures = 0;
+    Queries queries;
+    const RouteTimes expected = computeRouteTimes(
+                json::Dict{{"bus_wait_time", 6}, {"bus_velocity", 30},
+                           {"router_mode", std::string("on_demand")},
+                           {"graph_model", std::string("stop_pairs")}},
+                queries, failures);
+
+    const std::vector<Settings> settings = makeSettings();
+    for (const auto &[name, routing_settings] : settings)
+    {
+        const RouteTimes times = computeRouteTimes(routing_settings, queries, failures);
+        for (size_t query = 0; query < queries.size(); ++query)
+        {
+            const bool is_equal = expected[query].has_value() == times[query].has_value() &&
+                    (!expected[query].has_value() ||
+                     std::abs(*expected[query] - *times[query]) <= 1e-6 * std::max(1.0, *expected[query]));
+            if (!is_equal)
+            {
+                std::cerr << name << ": route " << queries[query].first << " -> " << queries[query].second
+                          << " takes " << times[query].value_or(-1.0) << " instead of "
+                          << expected[query].value_or(-1.0) << '\n';
+                ++failures;
+            }
+        }
+    }
+
+    if (failures != 0)
+    {
+        std::cerr << failures << " failures\n";
+        return 1;
+    }
+    std::cout << settings.size() << " router settings, " << queries.size() << " routes each: OK\n";
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace parallel
+{
+
+ThreadPool::ThreadPool(size_t thread_count)
+{
+    if (thread_count == 0)
+    {
+        thread_count = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    workers_.reserve(thread_count - 1);
+    for (size_t index = 1; index < thread_count; ++index)
+    {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+
+    for (auto &worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::getThreadCount() const
+{
+    return workers_.size() + 1;
+}
+
+void ThreadPool::parallelFor(size_t task_count, const Task &task)
+{
+    if (task_count == 0)
+    {
+        return;
+    }
+
+    if (workers_.empty() || task_count == 1)
+    {
+        for (size_t index = 0; index < task_count; ++index)
+        {
+            task(index);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        task_ = &task;
+        task_count_ = task_count;
+        next_task_.store(0);
+        busy_workers_ = workers_.size();
+        error_ = nullptr;
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    runTasks();
+
+    std::exception_ptr error;
+    {
+        std::unique_lock lock(mutex_);
+        done_.wait(lock, [this]() { return busy_workers_ == 0; });
+        task_ = nullptr;
+        std::swap(error, error_);
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::workerLoop()
+{
+    uint64_t seen_generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock lock(mutex_);
+            wake_.wait(lock, [this, seen_generation]()
+            {
+                return stop_ || generation_ != seen_generation;
+            });
+            if (stop_)
+            {
+                return;
+            }
+            seen_generation = generation_;
+        }
+
+        runTasks();
+
+        {
+            std::lock_guard lock(mutex_);
+            if (--busy_workers_ == 0)
+            {
+                done_.notify_one();
+            }
+        }
+    }
+}
+
+void ThreadPool::runTasks()
+{
+    for (size_t index = next_task_.fetch_add(1); index < task_count_;
+         index = next_task_.fetch_add(1))
+    {
+        try
+        {
+            (*task_)(index);
+        }
+        catch (...)
+        {
+            std::lock_guard lock(mutex_);
+            if (!error_)
+            {
+                error_ = std::current_exception();
+            }
+        }
+    }
+}
+
+} // namespace parallel
@@ -0,0 +1,61 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel
+{
+
+// Пул постоянных потоков для пакетной обработки независимых задач.
+// Вызывающий поток тоже участвует в работе, задачи разбираются
+// через общий атомарный счётчик.
+class ThreadPool
+{
+public:
+    using Task = std::function<void(size_t)>;
+
+    // 0 - по числу аппаратных потоков
+    explicit ThreadPool(size_t thread_count = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &other) = delete;
+
+    ThreadPool &operator=(const ThreadPool &other) = delete;
+
+    size_t getThreadCount() const;
+
+    // Выполняет task(0) ... task(task_count - 1) и дожидается завершения всех.
+    // Первое выброшенное задачей исключение пробрасывается вызывающему.
+    void parallelFor(size_t task_count, const Task &task);
+
+private:
+    void workerLoop();
+
+    void runTasks();
+
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    const Task *task_ = nullptr;
+    size_t task_count_ = 0;
+    std::atomic<size_t> next_task_{0};
+    size_t busy_workers_ = 0;
+    uint64_t generation_ = 0;
+    bool stop_ = false;
+    std::exception_ptr error_ = nullptr;
+};
+
+} // namespace parallel
+
+#endif // THREADPOOL_H
@@ -143,6 +143,30 @@ void TransportCatalogue::addBus(Bus &&_new_bus) noexcept
     busname_to_buses_[added_bus.name_] = &added_bus;
 }
 
+void TransportCatalogue::removeBus(std::string_view _name)
+{
+    const auto it = std::find_if(buses_.begin(), buses_.end(), [_name](const Bus &_bus)
+    {
+        return _bus.name_ == _name;
+    });
+    if (it == buses_.end())
+    {
+        return;
+    }
+
+    for (const auto &stop : it->route_)
+    {
+        stop_to_buses_.at(stop).erase(_name);
+    }
+    buses_.erase(it);
+
+    busname_to_buses_.clear();
+    for (auto &bus : buses_)
+    {
+        busname_to_buses_[bus.name_] = &bus;
+    }
+}
+
 TransportCatalogue::Bus *TransportCatalogue::findBus(std::string_view _name) const
 {
     if (busname_to_buses_.find(_name) != busname_to_buses_.end())
@@ -48,6 +48,9 @@ public:
 
     void addBus(Bus &&_new_bus) noexcept;
 
+    // Указатели на автобусы, полученные до удаления, недействительны
+    void removeBus(std::string_view _name);
+
     Bus *findBus(std::string_view _name) const;
 
     const std::set<std::string_view> &getNameBuses(std::string_view _name) const;
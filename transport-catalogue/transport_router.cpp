@@ -1,6 +1,40 @@
 #include "transport_router.h"
+#include "thread_pool.h"
 
+#include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+namespace
+{
+
+const double km_per_hour_to_m_per_min = 1000.0 / 60.0;
+
+// Ключ пары вершин ребра
+uint64_t makeEdgeKey(graph::VertexId _from, graph::VertexId _to)
+{
+    return (static_cast<uint64_t>(_from) << 32U) | static_cast<uint64_t>(_to);
+}
+
+// Точки вершин на плоскости для разбиения оверлея: долгота сжимается
+// косинусом широты, чтобы градусы по осям были соизмеримы
+std::vector<graph::MultilevelOverlay<double>::Point>
+makePlanePoints(const std::vector<geo::Coordinates> &_coordinates)
+{
+    std::vector<graph::MultilevelOverlay<double>::Point> points;
+    points.reserve(_coordinates.size());
+    for (const auto &point : _coordinates)
+    {
+        points.emplace_back(point.lng * std::cos(point.lat * M_PI / 180.0), point.lat);
+    }
+    return points;
+}
+
+} // namespace
 
 TransportRouter::TransportRouter() :
     graph_(0)
@@ -13,6 +47,95 @@ void TransportRouter::setInitSetting(bool value)
     this->is_init_ = value;
 }
 
+TransportRouter &TransportRouter::setRouterMode(RouterMode mode)
+{
+    this->router_mode_ = mode;
+    return *this;
+}
+
+TransportRouter::RouterMode TransportRouter::getRouterMode() const
+{
+    return this->router_mode_;
+}
+
+TransportRouter &TransportRouter::setGraphModel(GraphModel model)
+{
+    this->graph_model_ = model;
+    return *this;
+}
+
+TransportRouter::GraphModel TransportRouter::getGraphModel() const
+{
+    return this->graph_model_;
+}
+
+TransportRouter &TransportRouter::setAllPairsAlgorithm(graph::AllPairsAlgorithm algorithm)
+{
+    this->all_pairs_algorithm_ = algorithm;
+    return *this;
+}
+
+graph::AllPairsAlgorithm TransportRouter::getAllPairsAlgorithm() const
+{
+    return this->all_pairs_algorithm_;
+}
+
+TransportRouter &TransportRouter::setBuildThreads(size_t thread_count)
+{
+    this->build_threads_ = thread_count;
+    build_pool_.reset();
+    return *this;
+}
+
+size_t TransportRouter::getBuildThreads() const
+{
+    return this->build_threads_;
+}
+
+TransportRouter &TransportRouter::setLandmarkCount(size_t landmark_count)
+{
+    this->landmark_count_ = landmark_count;
+    return *this;
+}
+
+size_t TransportRouter::getLandmarkCount() const
+{
+    return this->landmark_count_;
+}
+
+TransportRouter &TransportRouter::setRowCacheBytes(size_t bytes)
+{
+    this->row_cache_bytes_ = bytes;
+    return *this;
+}
+
+size_t TransportRouter::getRowCacheBytes() const
+{
+    return this->row_cache_bytes_;
+}
+
+TransportRouter &TransportRouter::setTableWeightFormat(TableWeightFormat format)
+{
+    this->table_weight_format_ = format;
+    return *this;
+}
+
+TransportRouter::TableWeightFormat TransportRouter::getTableWeightFormat() const
+{
+    return this->table_weight_format_;
+}
+
+TransportRouter &TransportRouter::setOverlayCellSizes(std::vector<size_t> sizes)
+{
+    this->overlay_cell_sizes_ = std::move(sizes);
+    return *this;
+}
+
+const std::vector<size_t> &TransportRouter::getOverlayCellSizes() const
+{
+    return this->overlay_cell_sizes_;
+}
+
 TransportRouter &TransportRouter::setWaitTime(int time)
 {
     this->wait_time_ = static_cast<double>(time);
@@ -21,11 +144,26 @@ TransportRouter &TransportRouter::setWaitTime(int time)
 
 TransportRouter &TransportRouter::setVelocity(int velocity)
 {
-    static const double km_per_hour_to_m_per_min = 1000.0 / 60.0;
-    this->velocity_ = velocity * km_per_hour_to_m_per_min;
+    return setVelocityInMetersPerMinute(velocity * km_per_hour_to_m_per_min);
+}
+
+TransportRouter &TransportRouter::setVelocityInMetersPerMinute(double velocity)
+{
+    this->velocity_ = velocity;
+    this->edge_velocity_ = velocity;
+    this->ride_time_scale_ = 1.0;
     return *this;
 }
 
+parallel::ThreadPool &TransportRouter::getBuildPool()
+{
+    if (build_pool_ == nullptr)
+    {
+        build_pool_ = std::make_unique<parallel::ThreadPool>(build_threads_);
+    }
+    return *build_pool_;
+}
+
 void TransportRouter::createGraph(const TransportCatalogue &_catalogue)
 {
     if (!is_init_)
@@ -33,44 +171,542 @@ void TransportRouter::createGraph(const TransportCatalogue &_catalogue)
         return;
     }
 
+    if (router_mode_ == RouterMode::RAPTOR)
+    {
+        raptor_router_.build(_catalogue, wait_time_, velocity_);
+        return;
+    }
+
+    switch (graph_model_)
+    {
+    case GraphModel::STOP_PAIRS:
+    case GraphModel::MERGED_STOPS:
+        createStopPairsGraph(_catalogue);
+        break;
+    case GraphModel::LINE:
+        createLineGraph(_catalogue);
+        break;
+    }
+
+    if (router_mode_ == RouterMode::A_STAR)
+    {
+        computeMinTimePerMeter(_catalogue, _catalogue.getSortedBuses());
+    }
+
+    graph_.Freeze();
+    setRouterWithNewGraph();
+}
+
+void TransportRouter::createStopPairsGraph(const TransportCatalogue &_catalogue)
+{
     const std::vector<const domain::Stop *> sorted_used_stops =
             _catalogue.getSortedUsedStops();
 
+    const bool is_merged = graph_model_ == GraphModel::MERGED_STOPS;
+
     {
-        graph::DirectedWeightedGraph<double> buf(sorted_used_stops.size() * 2);
+        graph::DirectedWeightedGraph<double> buf(sorted_used_stops.size() * (is_merged ? 1 : 2));
         std::swap(buf, this->graph_);
     }
 
     for (const auto *stop : sorted_used_stops)
     {
-        vertexes_[stop->name_].waiting = vertexes_counter_++;
-        vertexes_[stop->name_].moving = vertexes_counter_++;
-        const graph::EdgeId idx =
-                graph_.AddEdge({vertexes_.at(stop->name_).waiting,
-                                vertexes_.at(stop->name_).moving,
-                                wait_time_});
-        wait_edges_.insert({idx, {stop->name_, wait_time_} });
+        VertexIds &ids = vertexes_[stop->name_];
+        ids.stop = static_cast<uint32_t>(stop_names_.size());
+        stop_names_.push_back(stop->name_);
+
+        if (is_merged)
+        {
+            bindVertexToStop(vertexes_counter_, *stop);
+            ids.waiting = vertexes_counter_;
+            ids.moving = vertexes_counter_;
+            ++vertexes_counter_;
+            continue;
+        }
+
+        bindVertexToStop(vertexes_counter_, *stop);
+        ids.waiting = vertexes_counter_++;
+        bindVertexToStop(vertexes_counter_, *stop);
+        ids.moving = vertexes_counter_++;
+        addEdge({ids.waiting, ids.moving, wait_time_}, {EdgeKind::WAIT, ids.stop});
     }
 
     const std::vector<const domain::Bus *> buses = _catalogue.getSortedBuses();
-
+    std::vector<uint32_t> bus_indexes;
+    bus_indexes.reserve(buses.size());
     for (const auto *bus : buses)
     {
+        bus_indexes.push_back(static_cast<uint32_t>(bus_names_.size()));
+        bus_names_.push_back(bus->name_);
+    }
+
+    stageBusEdges(_catalogue, buses, bus_indexes);
+    addStagedEdges();
+}
+
+void TransportRouter::stageBusEdges(const TransportCatalogue &_catalogue,
+                                    const std::vector<const domain::Bus *> &_buses,
+                                    const std::vector<uint32_t> &_bus_indexes)
+{
+    // Каждый автобус строит рёбра в свой буфер, буферы переносятся в граф
+    // в порядке автобусов, поэтому номера рёбер не зависят от числа потоков
+    std::vector<StagedEdges> bus_edges(_buses.size());
+    getBuildPool().parallelFor(_buses.size(), [&](size_t index)
+    {
+        const auto *bus = _buses[index];
         createEdgeBetweenStops(bus->route_.begin(), bus->route_.end(),
-                               bus->name_, _catalogue);
+                               _bus_indexes[index], 0, _catalogue, bus_edges[index]);
         if (!bus->is_circul_)
         {
             createEdgeBetweenStops(bus->route_.rbegin(), bus->route_.rend(),
-                                   bus->name_, _catalogue);
+                                   _bus_indexes[index], static_cast<uint32_t>(bus->route_.size()),
+                                   _catalogue, bus_edges[index]);
+        }
+    });
+
+    for (auto &edges : bus_edges)
+    {
+        for (const auto &[edge, info] : edges)
+        {
+            stageEdge(edge, info);
+        }
+        StagedEdges().swap(edges);
+    }
+}
+
+void TransportRouter::updateBuses(const TransportCatalogue &_catalogue,
+                                  const std::vector<const domain::Bus *> &_buses)
+{
+    // Линейный граф нумерует вершины по автобусам, RAPTOR графа не строит:
+    // маршрутизатор строится заново по справочнику
+    if (graph_model_ == GraphModel::LINE || router_mode_ == RouterMode::RAPTOR)
+    {
+        vertexes_.clear();
+        vertexes_counter_ = 0;
+        edges_info_.clear();
+        stop_names_.clear();
+        bus_names_.clear();
+        vertex_coordinates_.clear();
+        createGraph(_catalogue);
+        createBusIndex(_catalogue);
+        createTimetable(_catalogue);
+        return;
+    }
+
+    for (const auto *bus : _buses)
+    {
+        for (const auto stop : bus->route_)
+        {
+            if (vertexes_.count(stop) == 0U)
+            {
+                throw std::invalid_argument("Bus stop has no vertex in the graph");
+            }
+        }
+    }
+
+    // Номера автобусов не меняются, новые автобусы дописываются в конец
+    std::unordered_map<std::string_view, uint32_t> bus_index_by_name;
+    for (size_t index = 0; index < bus_names_.size(); ++index)
+    {
+        bus_index_by_name.emplace(bus_names_[index], static_cast<uint32_t>(index));
+    }
+    std::vector<uint32_t> bus_indexes;
+    bus_indexes.reserve(_buses.size());
+    for (const auto *bus : _buses)
+    {
+        const auto [it, is_new] = bus_index_by_name.emplace(bus->name_,
+                                                            static_cast<uint32_t>(bus_names_.size()));
+        if (is_new)
+        {
+            bus_names_.push_back(bus->name_);
         }
+        bus_indexes.push_back(it->second);
     }
 
-    router_ = std::make_unique<graph::Router<double>>(graph::Router<double>(this->graph_));
+    std::unordered_map<uint64_t, graph::EdgeId> current_edges;
+    for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id)
+    {
+        const EdgeKind kind = edges_info_[edge_id].kind;
+        if ((kind == EdgeKind::BUS || kind == EdgeKind::WAIT_AND_BUS) && !graph_.IsEdgeRemoved(edge_id))
+        {
+            const auto &edge = graph_.GetEdge(edge_id);
+            current_edges.emplace(makeEdgeKey(edge.from, edge.to), edge_id);
+        }
+    }
+
+    // Сравнение новых рёбер автобусов с текущими по паре вершин
+    stageBusEdges(_catalogue, _buses, bus_indexes);
+    std::vector<graph::EdgeId> increased_edges;
+    std::vector<graph::EdgeId> decreased_edges;
+    for (const auto &[edge, info] : staged_edges_)
+    {
+        const auto it = current_edges.find(makeEdgeKey(edge.from, edge.to));
+        if (it == current_edges.end())
+        {
+            decreased_edges.push_back(addEdge(edge, info));
+            continue;
+        }
+
+        const graph::EdgeId edge_id = it->second;
+        current_edges.erase(it);
+        edges_info_[edge_id] = info;
+        const double weight = graph_.GetEdge(edge_id).weight;
+        if (edge.weight < weight)
+        {
+            decreased_edges.push_back(edge_id);
+        }
+        else if (weight < edge.weight)
+        {
+            increased_edges.push_back(edge_id);
+        }
+        graph_.SetEdgeWeight(edge_id, edge.weight);
+    }
+    std::vector<std::pair<graph::Edge<double>, EdgeInfo>>().swap(staged_edges_);
+    std::unordered_map<uint64_t, size_t>().swap(staged_edge_index_);
+
+    for (const auto &[key, edge_id] : current_edges)
+    {
+        graph_.RemoveEdge(edge_id);
+        increased_edges.push_back(edge_id);
+    }
+    std::sort(increased_edges.begin(), increased_edges.end());
+    graph_.Freeze();
+
+    switch (router_mode_)
+    {
+    case RouterMode::PRECOMPUTE:
+        if (fixed_point_router_ != nullptr)
+        {
+            try
+            {
+                fixed_point_router_->UpdateEdges(increased_edges, decreased_edges, build_threads_);
+            }
+            catch (const std::overflow_error &)
+            {
+                // Новые маршруты не помещаются в uint32_t: таблица в double
+                table_weight_format_ = TableWeightFormat::DOUBLE;
+                setRouterWithNewGraph();
+            }
+            break;
+        }
+        router_->UpdateEdges(increased_edges, decreased_edges, build_threads_);
+        break;
+    case RouterMode::LAZY:
+        lazy_router_->UpdateEdges(increased_edges, decreased_edges);
+        break;
+    case RouterMode::A_STAR:
+        computeMinTimePerMeter(_catalogue, _buses);
+        break;
+    case RouterMode::CONTRACTION_HIERARCHY:
+    case RouterMode::ALT:
+    case RouterMode::HUB_LABELS:
+        // Предподсчёт зависит от всего графа и строится заново
+        setRouterWithNewGraph();
+        break;
+    case RouterMode::OVERLAY:
+        // Разбиение не зависит от рёбер, границы клеток и клики строятся заново
+        overlay_ = std::make_unique<graph::MultilevelOverlay<double>>(
+                    this->graph_, overlay_->GetPartition(), build_threads_);
+        break;
+    case RouterMode::ON_DEMAND:
+    case RouterMode::RAPTOR:
+        break;
+    }
+    createBusIndex(_catalogue);
+    createTimetable(_catalogue);
+}
+
+void TransportRouter::updateSettings(const TransportCatalogue &_catalogue,
+                                     std::optional<int> _wait_time, std::optional<int> _velocity,
+                                     bool _allow_rebuild)
+{
+    const double wait_time = _wait_time.has_value() ? static_cast<double>(*_wait_time) : wait_time_;
+    const double velocity = _velocity.has_value() ? *_velocity * km_per_hour_to_m_per_min : velocity_;
+    if (wait_time == wait_time_ && velocity == velocity_)
+    {
+        return;
+    }
+
+    const bool needs_rebuild = router_mode_ == RouterMode::PRECOMPUTE ||
+            router_mode_ == RouterMode::CONTRACTION_HIERARCHY ||
+            router_mode_ == RouterMode::ALT ||
+            router_mode_ == RouterMode::HUB_LABELS;
+    if (needs_rebuild && !_allow_rebuild)
+    {
+        throw std::invalid_argument("update rebuilds the router in this mode, set allow_rebuild");
+    }
+
+    this->wait_time_ = wait_time;
+    this->velocity_ = velocity;
+
+    if (router_mode_ == RouterMode::RAPTOR)
+    {
+        raptor_router_.build(_catalogue, wait_time_, velocity_);
+        createTimetable(_catalogue);
+        return;
+    }
+
+    // Время поездки обратно пропорционально скорости. Время в EdgeInfo не
+    // меняется, поэтому повторные изменения не копят погрешность
+    this->ride_time_scale_ = edge_velocity_ / velocity_;
+    for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id)
+    {
+        if (graph_.IsEdgeRemoved(edge_id))
+        {
+            continue;
+        }
+
+        const EdgeInfo &info = edges_info_[edge_id];
+        switch (info.kind)
+        {
+        case EdgeKind::WAIT:
+            graph_.SetEdgeWeight(edge_id, wait_time_);
+            break;
+        case EdgeKind::BUS:
+            graph_.SetEdgeWeight(edge_id, info.time * ride_time_scale_);
+            break;
+        case EdgeKind::WAIT_AND_BUS:
+            graph_.SetEdgeWeight(edge_id, wait_time_ + info.time * ride_time_scale_);
+            break;
+        case EdgeKind::NONE:
+            break;
+        }
+    }
+
+    if (router_mode_ == RouterMode::OVERLAY)
+    {
+        overlay_->Customize(build_threads_);
+    }
+    else
+    {
+        setRouterWithNewGraph();
+    }
+    createTimetable(_catalogue);
+}
+
+void TransportRouter::createLineGraph(const TransportCatalogue &_catalogue)
+{
+    const std::vector<const domain::Stop *> sorted_used_stops =
+            _catalogue.getSortedUsedStops();
+    const std::vector<const domain::Bus *> buses = _catalogue.getSortedBuses();
+
+    size_t vertex_count = sorted_used_stops.size();
+    for (const auto *bus : buses)
+    {
+        vertex_count += bus->route_.size() * (bus->is_circul_ ? 1U : 2U);
+    }
+
+    {
+        graph::DirectedWeightedGraph<double> buf(vertex_count);
+        std::swap(buf, this->graph_);
+    }
+
+    for (const auto *stop : sorted_used_stops)
+    {
+        VertexIds &ids = vertexes_[stop->name_];
+        ids.stop = static_cast<uint32_t>(stop_names_.size());
+        stop_names_.push_back(stop->name_);
+
+        bindVertexToStop(vertexes_counter_, *stop);
+        ids.waiting = vertexes_counter_;
+        ids.moving = vertexes_counter_;
+        ++vertexes_counter_;
+    }
+
+    // Вершины автобусов идут подряд в порядке автобусов, первая вершина
+    // каждого известна заранее и автобусы обрабатываются параллельно
+    std::vector<graph::VertexId> first_on_bus(buses.size());
+    for (size_t bus_index = 0; bus_index < buses.size(); ++bus_index)
+    {
+        bus_names_.push_back(buses[bus_index]->name_);
+        first_on_bus[bus_index] = vertexes_counter_;
+        vertexes_counter_ += buses[bus_index]->route_.size() * (buses[bus_index]->is_circul_ ? 1U : 2U);
+    }
+
+    // Координаты вершин автобусов заполняются из разных потоков, размер
+    // массива задаётся заранее
+    if (router_mode_ == RouterMode::A_STAR || router_mode_ == RouterMode::OVERLAY)
+    {
+        vertex_coordinates_.resize(vertex_count);
+    }
+
+    std::vector<StagedEdges> bus_edges(buses.size());
+    getBuildPool().parallelFor(buses.size(), [&](size_t bus_index)
+    {
+        const auto *bus = buses[bus_index];
+        const auto route_size = static_cast<uint32_t>(bus->route_.size());
+        createLineEdges(bus->route_.begin(), bus->route_.end(), static_cast<uint32_t>(bus_index), 0,
+                        first_on_bus[bus_index], _catalogue, bus_edges[bus_index]);
+        if (!bus->is_circul_)
+        {
+            createLineEdges(bus->route_.rbegin(), bus->route_.rend(), static_cast<uint32_t>(bus_index),
+                            route_size, first_on_bus[bus_index] + route_size, _catalogue,
+                            bus_edges[bus_index]);
+        }
+    });
+
+    for (auto &edges : bus_edges)
+    {
+        for (const auto &[edge, info] : edges)
+        {
+            addEdge(edge, info);
+        }
+        StagedEdges().swap(edges);
+    }
+}
+
+graph::EdgeId TransportRouter::addEdge(const graph::Edge<double> &_edge, const EdgeInfo &_info)
+{
+    const graph::EdgeId edge_id = graph_.AddEdge(_edge);
+    edges_info_.push_back(_info);
+    return edge_id;
+}
+
+void TransportRouter::stageEdge(const graph::Edge<double> &_edge, const EdgeInfo &_info)
+{
+    const auto [it, is_new] = staged_edge_index_.emplace(makeEdgeKey(_edge.from, _edge.to),
+                                                         staged_edges_.size());
+    if (is_new)
+    {
+        staged_edges_.emplace_back(_edge, _info);
+        return;
+    }
+
+    // Параллельное ребро не нужно маршрутизатору: путь всегда пойдёт по
+    // самому лёгкому, при равных весах - по первому добавленному
+    auto &[edge, info] = staged_edges_[it->second];
+    if (_edge.weight < edge.weight)
+    {
+        edge = _edge;
+        info = _info;
+    }
+}
+
+void TransportRouter::addStagedEdges()
+{
+    for (const auto &[edge, info] : staged_edges_)
+    {
+        addEdge(edge, info);
+    }
+
+    std::vector<std::pair<graph::Edge<double>, EdgeInfo>>().swap(staged_edges_);
+    std::unordered_map<uint64_t, size_t>().swap(staged_edge_index_);
+}
+
+void TransportRouter::bindVertexToStop(graph::VertexId _vertex, const domain::Stop &_stop)
+{
+    if (router_mode_ != RouterMode::A_STAR && router_mode_ != RouterMode::OVERLAY)
+    {
+        return;
+    }
+
+    if (vertex_coordinates_.size() <= _vertex)
+    {
+        vertex_coordinates_.resize(_vertex + 1);
+    }
+    vertex_coordinates_[_vertex] = {_stop.latitude_, _stop.longitude_};
+}
+
+void TransportRouter::computeMinTimePerMeter(const TransportCatalogue &_catalogue,
+                                             const std::vector<const domain::Bus *> &_buses)
+{
+    // Дорога может быть короче расстояния по прямой, поэтому скорость
+    // поправляем на наименьшее отношение длины перегона к расстоянию по прямой.
+    // Оценка по нескольким перегонам остаётся нижней по неравенству треугольника
+    double min_ratio = 1.0;
+    for (const auto *bus : _buses)
+    {
+        for (size_t index = 1; index < bus->route_.size(); ++index)
+        {
+            const auto *from = _catalogue.findStop(bus->route_[index - 1]);
+            const auto *to = _catalogue.findStop(bus->route_[index]);
+            const double geo_distance = geo::ComputeDistance({from->latitude_, from->longitude_},
+                                                             {to->latitude_, to->longitude_});
+            if (!(geo_distance > 0.0))
+            {
+                continue;
+            }
+
+            for (const auto &key : {std::pair{from->name_, to->name_},
+                                    std::pair{to->name_, from->name_}})
+            {
+                const auto distance = _catalogue.getDistancesBetweenStops(key);
+                if (distance.has_value())
+                {
+                    min_ratio = std::min(min_ratio, *distance / geo_distance);
+                }
+            }
+        }
+    }
+
+    // Запас на погрешность вычисления расстояний
+    static const double rounding_margin = 1.0 - 1e-6;
+    this->min_time_per_meter_ = min_ratio * rounding_margin / this->edge_velocity_;
+}
+
+void TransportRouter::createTimetable(const TransportCatalogue &_catalogue)
+{
+    if (!is_init_)
+    {
+        return;
+    }
+
+    csa_router_.build(_catalogue, velocity_);
+}
+
+void TransportRouter::createBusIndex(const TransportCatalogue &_catalogue)
+{
+    bus_edges_.assign(bus_names_.size(), {});
+    for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id)
+    {
+        const EdgeInfo &info = edges_info_[edge_id];
+        if ((info.kind == EdgeKind::BUS || info.kind == EdgeKind::WAIT_AND_BUS) &&
+                !graph_.IsEdgeRemoved(edge_id))
+        {
+            bus_edges_[info.bus].push_back(edge_id);
+        }
+    }
+
+    bus_routes_.assign(bus_names_.size(), {});
+    for (size_t bus_index = 0; bus_index < bus_names_.size(); ++bus_index)
+    {
+        // Удалённый обновлением автобус остаётся в bus_names_ без рёбер
+        const domain::Bus *bus = _catalogue.findBus(bus_names_[bus_index]);
+        if (bus == nullptr)
+        {
+            continue;
+        }
+
+        auto &route = bus_routes_[bus_index];
+        route.reserve(bus->route_.size() * (bus->is_circul_ ? 1U : 2U));
+        for (const auto stop : bus->route_)
+        {
+            route.push_back(vertexes_.at(stop).stop);
+        }
+        if (!bus->is_circul_)
+        {
+            for (auto it = bus->route_.rbegin(); it != bus->route_.rend(); ++it)
+            {
+                route.push_back(vertexes_.at(*it).stop);
+            }
+        }
+    }
+}
+
+std::optional<std::pair<double, std::vector<TransportRouter::RouteItem>>>
+TransportRouter::buildRoute(std::string_view _from, std::string_view _to, double _departure_time) const
+{
+    return csa_router_.buildRoute(_from, _to, _departure_time);
 }
 
 std::optional<std::pair<double, std::vector<TransportRouter::RouteItem> > >
 TransportRouter::buildRoute(std::string_view _from, std::string_view _to) const
 {
+    if (router_mode_ == RouterMode::RAPTOR)
+    {
+        return raptor_router_.buildRoute(_from, _to);
+    }
+
     if (vertexes_.count(_from) == 0U || vertexes_.count(_to) == 0U)
     {
         return {};
@@ -80,36 +716,331 @@ TransportRouter::buildRoute(std::string_view _from, std::string_view _to) const
     const graph::VertexId to_vertex = vertexes_.at(_to).waiting;
 
     std::optional<graph::Router<double>::RouteInfo> route_info =
-            router_->BuildRoute(from_vertex, to_vertex);
+            buildInternalRoute(from_vertex, to_vertex);
+
+    if (!route_info.has_value())
+    {
+        return {};
+    }
+
+    return makeRoute(*route_info);
+}
+
+std::optional<std::pair<double, std::vector<TransportRouter::RouteItem>>>
+TransportRouter::buildRoute(std::string_view _from, std::string_view _to,
+                            const RouteExclusions &_exclusions,
+                            const RouteProfile &_profile) const
+{
+    const bool is_reweighted = _profile.wait_time.has_value() || _profile.velocity.has_value();
+    if (_exclusions.stops.empty() && _exclusions.buses.empty() && _exclusions.segments.empty() &&
+            !is_reweighted)
+    {
+        return buildRoute(_from, _to);
+    }
+
+    if (router_mode_ == RouterMode::RAPTOR)
+    {
+        throw RouteOptionsError("Route exclusions and profiles need a graph");
+    }
+
+    if (_profile.wait_time.value_or(0.0) < 0.0 || _profile.velocity.value_or(1.0) <= 0.0)
+    {
+        throw RouteOptionsError("Route profile needs non-negative wait time and positive velocity");
+    }
+
+    if (vertexes_.count(_from) == 0U || vertexes_.count(_to) == 0U)
+    {
+        return {};
+    }
+
+    // Маска строится только по закрытым остановкам и рёбрам затронутых
+    // автобусов, остальной граф запрос не обходит
+    std::unordered_set<graph::VertexId> blocked_vertices;
+    for (const auto stop : _exclusions.stops)
+    {
+        if (const auto it = vertexes_.find(stop); it != vertexes_.end())
+        {
+            blocked_vertices.insert(it->second.waiting);
+            blocked_vertices.insert(it->second.moving);
+        }
+    }
+    // С закрытой остановки нельзя уехать
+    if (blocked_vertices.count(vertexes_.at(_from).waiting) != 0U)
+    {
+        return {};
+    }
+
+    std::unordered_set<graph::EdgeId> blocked_edges;
+    for (const auto bus : _exclusions.buses)
+    {
+        const auto it = std::find(bus_names_.begin(), bus_names_.end(), bus);
+        if (it != bus_names_.end())
+        {
+            const auto &edges = bus_edges_[static_cast<size_t>(it - bus_names_.begin())];
+            blocked_edges.insert(edges.begin(), edges.end());
+        }
+    }
+    if (!_exclusions.segments.empty())
+    {
+        blockRidesThroughSegments(_exclusions.segments, blocked_edges);
+    }
+
+    // Расстояние в EdgeInfo не хранится, но время поездки пропорционально
+    // ему, поэтому новая скорость - множитель времени поездки
+    const double wait_time = _profile.wait_time.value_or(wait_time_);
+    const double ride_time_scale = _profile.velocity.has_value() ?
+                this->edge_velocity_ / (*_profile.velocity * km_per_hour_to_m_per_min) :
+                this->ride_time_scale_;
+
+    const auto route_info = dijkstra_router_->BuildReweightedRoute(
+                vertexes_.at(_from).waiting, vertexes_.at(_to).waiting,
+                [&](graph::EdgeId _edge_id, graph::VertexId _edge_to, double _edge_weight) -> std::optional<double>
+    {
+        if ((!blocked_edges.empty() && blocked_edges.count(_edge_id) != 0U) ||
+                (!blocked_vertices.empty() && blocked_vertices.count(_edge_to) != 0U) ||
+                _edge_weight == graph::InfiniteWeight<double>())
+        {
+            return std::nullopt;
+        }
+        if (!is_reweighted)
+        {
+            return _edge_weight;
+        }
 
+        const EdgeInfo &info = edges_info_[_edge_id];
+        switch (info.kind)
+        {
+        case EdgeKind::WAIT:
+            return wait_time;
+        case EdgeKind::BUS:
+            return info.time * ride_time_scale;
+        case EdgeKind::WAIT_AND_BUS:
+            return wait_time + info.time * ride_time_scale;
+        case EdgeKind::NONE:
+            break;
+        }
+        return _edge_weight;
+    });
     if (!route_info.has_value())
     {
         return {};
     }
 
+    return makeRoute(*route_info, wait_time, ride_time_scale);
+}
+
+void TransportRouter::blockRidesThroughSegments(const std::vector<RouteExclusions::Segment> &_segments,
+                                                std::unordered_set<graph::EdgeId> &_blocked_edges) const
+{
+    // Перегоны с известными остановками: имя автобуса и номера остановок
+    std::vector<std::tuple<std::string_view, uint32_t, uint32_t>> segments;
+    for (const auto &segment : _segments)
+    {
+        const auto from = vertexes_.find(segment.from);
+        const auto to = vertexes_.find(segment.to);
+        if (from != vertexes_.end() && to != vertexes_.end())
+        {
+            segments.emplace_back(segment.bus, from->second.stop, to->second.stop);
+        }
+    }
+
+    // Номера остановок в маршруте автобуса, с которых начинаются закрытые перегоны
+    std::vector<uint32_t> positions;
+    for (size_t bus = 0; bus < bus_routes_.size(); ++bus)
+    {
+        const auto &route = bus_routes_[bus];
+        positions.clear();
+        for (const auto &[bus_name, from, to] : segments)
+        {
+            if (!bus_name.empty() && bus_name != bus_names_[bus])
+            {
+                continue;
+            }
+            // Стык прямого и обратного направлений ни одна поездка не проходит
+            for (size_t position = 0; position + 1 < route.size(); ++position)
+            {
+                if (route[position] == from && route[position + 1] == to)
+                {
+                    positions.push_back(static_cast<uint32_t>(position));
+                }
+            }
+        }
+        if (positions.empty())
+        {
+            continue;
+        }
+        std::sort(positions.begin(), positions.end());
+
+        // Поездка проходит перегоны с position по position + span_count - 1
+        for (const graph::EdgeId edge_id : bus_edges_[bus])
+        {
+            const EdgeInfo &info = edges_info_[edge_id];
+            const auto it = std::lower_bound(positions.begin(), positions.end(), info.position);
+            if (it != positions.end() && *it < info.position + info.span_count)
+            {
+                _blocked_edges.insert(edge_id);
+            }
+        }
+    }
+}
+
+std::pair<double, std::vector<TransportRouter::RouteItem>>
+TransportRouter::makeRoute(const graph::Router<double>::RouteInfo &_route_info) const
+{
+    return makeRoute(_route_info, wait_time_, ride_time_scale_);
+}
+
+std::pair<double, std::vector<TransportRouter::RouteItem>>
+TransportRouter::makeRoute(const graph::Router<double>::RouteInfo &_route_info,
+                           double _wait_time, double _ride_time_scale) const
+{
     std::pair<double, std::vector<RouteItem>> output;
-    output.first = route_info->weight;
+    output.first = _route_info.weight;
 
     auto& items = output.second;
 
-    for (const auto& edge_id : route_info->edges)
+    // Номер автобуса, если последний элемент - поездка
+    std::optional<uint32_t> last_bus;
+    for (const auto edge_id : _route_info.edges)
     {
-        if (bus_edges_.count(edge_id) > 0)
+        const EdgeInfo &info = edges_info_[edge_id];
+
+        // В модели с объединёнными вершинами ребро автобуса включает
+        // ожидание на остановке отправления и даёт оба элемента
+        if (info.kind == EdgeKind::WAIT || info.kind == EdgeKind::WAIT_AND_BUS)
         {
-            items.emplace_back(bus_edges_.at(edge_id));
-            continue;
+            items.emplace_back(domain::WaitInfo{stop_names_[info.stop], _wait_time});
+            last_bus.reset();
         }
 
-        if (wait_edges_.count(edge_id) > 0)
+        if (info.kind == EdgeKind::BUS || info.kind == EdgeKind::WAIT_AND_BUS)
         {
-            items.emplace_back(wait_edges_.at(edge_id));
-            continue;
+            // В линейной модели поездка без пересадки - цепочка рёбер
+            // по одному перегону, собираем её в один элемент
+            if (last_bus == info.bus)
+            {
+                auto &last_bus_info = std::get<domain::BusRouteInfo>(items.back());
+                last_bus_info.span_count += static_cast<int>(info.span_count);
+                last_bus_info.time += info.time * _ride_time_scale;
+                continue;
+            }
+            items.emplace_back(domain::BusRouteInfo{bus_names_[info.bus],
+                                                    static_cast<int>(info.span_count),
+                                                    info.time * _ride_time_scale});
+            last_bus = info.bus;
         }
     }
 
     return output;
 }
 
+TransportRouter::Isochrone TransportRouter::buildIsochrone(std::string_view _from, double _max_time) const
+{
+    Isochrone output;
+
+    if (router_mode_ == RouterMode::RAPTOR)
+    {
+        output = raptor_router_.buildIsochrone(_from, _max_time);
+    }
+    else if (vertexes_.count(_from) != 0U)
+    {
+        dijkstra_router_->SearchWithin(vertexes_.at(_from).waiting, _max_time);
+        for (const auto name : stop_names_)
+        {
+            if (const auto time = dijkstra_router_->GetSettledWeight(vertexes_.at(name).waiting))
+            {
+                output.emplace_back(name, *time);
+            }
+        }
+    }
+
+    std::sort(output.begin(), output.end(), [](const auto &_lhs, const auto &_rhs)
+    {
+        return std::tie(_lhs.second, _lhs.first) < std::tie(_rhs.second, _rhs.first);
+    });
+
+    return output;
+}
+
+TransportRouter::RouteMatrix
+TransportRouter::buildRouteMatrix(const std::vector<std::string_view> &_origins,
+                                  const std::vector<std::string_view> &_destinations,
+                                  bool _with_items) const
+{
+    RouteMatrix output(_origins.size() * _destinations.size());
+
+    if (router_mode_ == RouterMode::RAPTOR)
+    {
+        for (size_t row = 0; row < _origins.size(); ++row)
+        {
+            for (size_t column = 0; column < _destinations.size(); ++column)
+            {
+                auto &route = output[row * _destinations.size() + column];
+                route = raptor_router_.buildRoute(_origins[row], _destinations[column]);
+                if (route.has_value() && !_with_items)
+                {
+                    route->second.clear();
+                }
+            }
+        }
+        return output;
+    }
+
+    // Остановки без вершин в графе остаются без маршрутов
+    std::vector<graph::VertexId> from_vertexes;
+    std::vector<size_t> rows;
+    for (size_t row = 0; row < _origins.size(); ++row)
+    {
+        if (const auto it = vertexes_.find(_origins[row]); it != vertexes_.end())
+        {
+            from_vertexes.push_back(it->second.waiting);
+            rows.push_back(row);
+        }
+    }
+    std::vector<graph::VertexId> to_vertexes;
+    std::vector<size_t> columns;
+    for (size_t column = 0; column < _destinations.size(); ++column)
+    {
+        if (const auto it = vertexes_.find(_destinations[column]); it != vertexes_.end())
+        {
+            to_vertexes.push_back(it->second.waiting);
+            columns.push_back(column);
+        }
+    }
+
+    const auto routes = buildInternalRouteMatrix(from_vertexes, to_vertexes, _with_items);
+    for (size_t row = 0; row < rows.size(); ++row)
+    {
+        for (size_t column = 0; column < columns.size(); ++column)
+        {
+            const auto &route_info = routes[row * columns.size() + column];
+            if (route_info.has_value())
+            {
+                output[rows[row] * _destinations.size() + columns[column]] = makeRoute(*route_info);
+            }
+        }
+    }
+
+    return output;
+}
+
+std::optional<double> TransportRouter::computeTravelTime(std::string_view _from,
+                                                        std::string_view _to) const
+{
+    if (router_mode_ != RouterMode::HUB_LABELS)
+    {
+        const auto route = buildRoute(_from, _to);
+        return route.has_value() ? std::optional<double>(route->first) : std::nullopt;
+    }
+
+    if (vertexes_.count(_from) == 0U || vertexes_.count(_to) == 0U)
+    {
+        return {};
+    }
+
+    return hub_labels_->GetDistance(vertexes_.at(_from).waiting, vertexes_.at(_to).waiting);
+}
+
 std::pair<double, double> TransportRouter::getSettings() const
 {
     return {wait_time_, velocity_};
@@ -125,6 +1056,28 @@ const graph::Router<double> *TransportRouter::getInternalRouter() const
     return this->router_.get();
 }
 
+graph::Router<double, uint32_t> *TransportRouter::getFixedPointRouter()
+{
+    return this->fixed_point_router_.get();
+}
+
+const graph::Router<double, uint32_t> *TransportRouter::getFixedPointRouter() const
+{
+    return this->fixed_point_router_.get();
+}
+
+const graph::ContractionHierarchy<double> *TransportRouter::getContractionHierarchy() const
+{
+    return this->contraction_hierarchy_.get();
+}
+
+void TransportRouter::loadContractionHierarchy(std::vector<uint32_t> _ranks,
+                                               std::vector<graph::ContractionHierarchy<double>::Shortcut> _shortcuts)
+{
+    contraction_hierarchy_ = std::make_unique<graph::ContractionHierarchy<double>>(
+                this->graph_, std::move(_ranks), std::move(_shortcuts));
+}
+
 graph::DirectedWeightedGraph<double> &TransportRouter::getGraph()
 {
     return this->graph_;
@@ -145,27 +1098,284 @@ const std::unordered_map<std::string_view, TransportRouter::VertexIds> &Transpor
     return this->vertexes_;
 }
 
-std::unordered_map<graph::EdgeId, domain::WaitInfo> &TransportRouter::getWaitEdges()
+std::vector<TransportRouter::EdgeInfo> &TransportRouter::getEdgesInfo()
+{
+    return this->edges_info_;
+}
+
+const std::vector<TransportRouter::EdgeInfo> &TransportRouter::getEdgesInfo() const
+{
+    return this->edges_info_;
+}
+
+std::vector<std::string_view> &TransportRouter::getStopNames()
 {
-    return this->wait_edges_;
+    return this->stop_names_;
 }
 
-const std::unordered_map<graph::EdgeId, domain::WaitInfo> &TransportRouter::getWaitEdges() const
+const std::vector<std::string_view> &TransportRouter::getStopNames() const
 {
-    return this->wait_edges_;
+    return this->stop_names_;
 }
 
-std::unordered_map<graph::EdgeId, domain::BusRouteInfo> &TransportRouter::getBusEdges()
+std::vector<std::string_view> &TransportRouter::getBusNames()
 {
-    return this->bus_edges_;
+    return this->bus_names_;
 }
 
-const std::unordered_map<graph::EdgeId, domain::BusRouteInfo> &TransportRouter::getBusEdges() const
+const std::vector<std::string_view> &TransportRouter::getBusNames() const
 {
-    return this->bus_edges_;
+    return this->bus_names_;
 }
 
-void TransportRouter::setRouterWithNewGraph()
+std::vector<geo::Coordinates> &TransportRouter::getVertexCoordinates()
 {
-    router_ = std::make_unique<graph::Router<double>>(graph::Router<double>(this->graph_));
+    return this->vertex_coordinates_;
+}
+
+const std::vector<geo::Coordinates> &TransportRouter::getVertexCoordinates() const
+{
+    return this->vertex_coordinates_;
+}
+
+TransportRouter &TransportRouter::setMinTimePerMeter(double time)
+{
+    this->min_time_per_meter_ = time;
+    return *this;
+}
+
+double TransportRouter::getMinTimePerMeter() const
+{
+    return this->min_time_per_meter_;
+}
+
+const graph::Landmarks<double> *TransportRouter::getLandmarks() const
+{
+    return this->landmarks_.get();
+}
+
+void TransportRouter::loadLandmarks(std::vector<graph::VertexId> _landmarks,
+                                    std::vector<double> _distances_from,
+                                    std::vector<double> _distances_to)
+{
+    landmarks_ = std::make_unique<graph::Landmarks<double>>(
+                this->graph_, std::move(_landmarks),
+                std::move(_distances_from), std::move(_distances_to));
+}
+
+const graph::MultilevelOverlay<double> *TransportRouter::getOverlay() const
+{
+    return this->overlay_.get();
+}
+
+void TransportRouter::loadOverlay(graph::MultilevelOverlay<double>::Partition _partition,
+                                  const std::vector<graph::MultilevelOverlay<double>::Cliques> &_cliques)
+{
+    overlay_ = std::make_unique<graph::MultilevelOverlay<double>>(
+                this->graph_, std::move(_partition), _cliques);
+}
+
+const graph::HubLabels<double> *TransportRouter::getHubLabels() const
+{
+    return this->hub_labels_.get();
+}
+
+void TransportRouter::loadHubLabels(graph::HubLabels<double>::Labels _out_labels,
+                                    graph::HubLabels<double>::Labels _in_labels)
+{
+    hub_labels_ = std::make_unique<graph::HubLabels<double>>(
+                this->graph_, std::move(_out_labels), std::move(_in_labels));
+}
+
+size_t TransportRouter::getLastSettledCount() const
+{
+    return dijkstra_router_ != nullptr ? dijkstra_router_->GetSettledCount() : 0U;
+}
+
+void TransportRouter::setRouterWithNewGraph(bool _compute_routes)
+{
+    router_.reset();
+    fixed_point_router_.reset();
+    dijkstra_router_.reset();
+    contraction_hierarchy_.reset();
+    landmarks_.reset();
+    hub_labels_.reset();
+    lazy_router_.reset();
+    overlay_.reset();
+
+    switch (router_mode_)
+    {
+    case RouterMode::PRECOMPUTE:
+        if (table_weight_format_ == TableWeightFormat::FIXED_POINT)
+        {
+            // Перегон в d метров весит 3 * d единиц, ожидание в t минут -
+            // 50 * t * v единиц при скорости v км/ч
+            try
+            {
+                fixed_point_router_ = std::make_unique<graph::Router<double, uint32_t>>(
+                            this->graph_, _compute_routes, all_pairs_algorithm_, build_threads_,
+                            3.0 * velocity_);
+                break;
+            }
+            catch (const std::overflow_error &)
+            {
+                // Самый длинный маршрут не помещается в uint32_t, таблица
+                // строится в double и сохраняется в базу в этом формате
+                table_weight_format_ = TableWeightFormat::DOUBLE;
+            }
+        }
+        router_ = std::make_unique<graph::Router<double>>(this->graph_, _compute_routes,
+                                                          all_pairs_algorithm_, build_threads_);
+        break;
+    case RouterMode::ON_DEMAND:
+    case RouterMode::A_STAR:
+        dijkstra_router_ = std::make_unique<graph::DijkstraRouter<double>>(this->graph_);
+        break;
+    case RouterMode::ALT:
+        dijkstra_router_ = std::make_unique<graph::DijkstraRouter<double>>(this->graph_);
+        if (_compute_routes)
+        {
+            landmarks_ = std::make_unique<graph::Landmarks<double>>(this->graph_, landmark_count_);
+        }
+        break;
+    case RouterMode::HUB_LABELS:
+        dijkstra_router_ = std::make_unique<graph::DijkstraRouter<double>>(this->graph_);
+        if (_compute_routes)
+        {
+            hub_labels_ = std::make_unique<graph::HubLabels<double>>(this->graph_);
+        }
+        break;
+    case RouterMode::LAZY:
+        lazy_router_ = std::make_unique<graph::LazyRouter<double>>(this->graph_, row_cache_bytes_);
+        break;
+    case RouterMode::CONTRACTION_HIERARCHY:
+        if (_compute_routes)
+        {
+            contraction_hierarchy_ =
+                    std::make_unique<graph::ContractionHierarchy<double>>(this->graph_);
+        }
+        break;
+    case RouterMode::OVERLAY:
+        if (_compute_routes)
+        {
+            overlay_ = std::make_unique<graph::MultilevelOverlay<double>>(
+                        this->graph_, overlay_cell_sizes_, build_threads_,
+                        makePlanePoints(vertex_coordinates_));
+        }
+        // Координаты нужны только разбиению, в базу они не попадают
+        std::vector<geo::Coordinates>().swap(vertex_coordinates_);
+        break;
+    case RouterMode::RAPTOR:
+        break;
+    }
+
+    // Изохроны в любом режиме на графе считает ограниченный поиск Дейкстры
+    if (router_mode_ != RouterMode::RAPTOR && dijkstra_router_ == nullptr)
+    {
+        dijkstra_router_ = std::make_unique<graph::DijkstraRouter<double>>(this->graph_);
+    }
+}
+
+std::optional<graph::Router<double>::RouteInfo>
+TransportRouter::buildInternalRoute(graph::VertexId _from, graph::VertexId _to) const
+{
+    switch (router_mode_)
+    {
+    case RouterMode::PRECOMPUTE:
+        if (fixed_point_router_ != nullptr)
+        {
+            auto route_info = fixed_point_router_->BuildRoute(_from, _to);
+            if (!route_info.has_value())
+            {
+                return std::nullopt;
+            }
+            return graph::Router<double>::RouteInfo{route_info->weight, std::move(route_info->edges)};
+        }
+        return router_->BuildRoute(_from, _to);
+    case RouterMode::ON_DEMAND:
+        return dijkstra_router_->BuildRoute(_from, _to);
+    case RouterMode::CONTRACTION_HIERARCHY:
+        return contraction_hierarchy_->BuildRoute(_from, _to);
+    case RouterMode::LAZY:
+        return lazy_router_->BuildRoute(_from, _to);
+    case RouterMode::OVERLAY:
+        return overlay_->BuildRoute(_from, _to);
+    case RouterMode::A_STAR:
+    {
+        const geo::Coordinates target = vertex_coordinates_.at(_to);
+        return dijkstra_router_->BuildRoute(_from, _to, [this, &target](graph::VertexId _vertex)
+        {
+            // acos у совпадающих точек может дать NaN, тогда оценка нулевая
+            return min_time_per_meter_ * ride_time_scale_ *
+                    std::max(0.0, geo::ComputeDistance(vertex_coordinates_[_vertex], target));
+        });
+    }
+    case RouterMode::ALT:
+        return dijkstra_router_->BuildRoute(_from, _to, [this, _to](graph::VertexId _vertex)
+        {
+            return landmarks_->GetLowerBound(_vertex, _to);
+        });
+    case RouterMode::HUB_LABELS:
+        // Оценка точная, поиск идёт почти только по вершинам маршрута
+        return dijkstra_router_->BuildRoute(_from, _to, [this, _to](graph::VertexId _vertex)
+        {
+            return hub_labels_->GetDistance(_vertex, _to).
+                    value_or(graph::InfiniteWeight<double>());
+        });
+    case RouterMode::RAPTOR:
+        break;
+    }
+    return std::nullopt;
+}
+
+std::vector<std::optional<graph::Router<double>::RouteInfo>>
+TransportRouter::buildInternalRouteMatrix(const std::vector<graph::VertexId> &_from,
+                                          const std::vector<graph::VertexId> &_to,
+                                          bool _with_edges) const
+{
+    if (router_mode_ == RouterMode::CONTRACTION_HIERARCHY)
+    {
+        return contraction_hierarchy_->BuildRouteMatrix(_from, _to, _with_edges);
+    }
+
+    std::vector<std::optional<graph::Router<double>::RouteInfo>> output;
+    output.reserve(_from.size() * _to.size());
+    for (const graph::VertexId from : _from)
+    {
+        switch (router_mode_)
+        {
+        case RouterMode::HUB_LABELS:
+            if (!_with_edges)
+            {
+                for (const graph::VertexId to : _to)
+                {
+                    const auto weight = hub_labels_->GetDistance(from, to);
+                    output.push_back(weight.has_value()
+                                     ? std::optional(graph::Router<double>::RouteInfo{*weight, {}})
+                                     : std::nullopt);
+                }
+                break;
+            }
+            [[fallthrough]];
+        case RouterMode::ON_DEMAND:
+        case RouterMode::A_STAR:
+        case RouterMode::ALT:
+        {
+            // Оценки A* и ALT привязаны к одной цели, дерево поиска
+            // на всю строку строит обычный Дейкстра
+            auto routes = dijkstra_router_->BuildRoutes(from, _to, _with_edges);
+            std::move(routes.begin(), routes.end(), std::back_inserter(output));
+            break;
+        }
+        default:
+            // В таблице маршрутов и кэше строк каждая ячейка и так не требует поиска
+            for (const graph::VertexId to : _to)
+            {
+                output.push_back(buildInternalRoute(from, to));
+            }
+            break;
+        }
+    }
+
+    return output;
 }
@@ -2,9 +2,21 @@
 #define TRANSPORTROUTER_H
 
 #include <memory>
+#include <stdexcept>
+#include <unordered_set>
 #include <variant>
 
+#include "contraction_hierarchy.h"
+#include "csa_router.h"
+#include "dijkstra_router.h"
+#include "hub_labels.h"
+#include "landmarks.h"
+#include "lazy_router.h"
+#include "libs/geo.h"
+#include "multilevel_overlay.h"
+#include "raptor_router.h"
 #include "router.h"
+#include "thread_pool.h"
 #include "transport_catalogue.h"
 
 class TransportRouter
@@ -14,29 +26,246 @@ public:
     {
         graph::VertexId waiting = 0;
         graph::VertexId moving = 0;
+        // Номер остановки в getStopNames()
+        uint32_t stop = 0;
     };
 
-    using RouteItem = std::variant<std::monostate, domain::WaitInfo, domain::BusRouteInfo>;
+    enum class EdgeKind : uint8_t
+    {
+        // Ребро высадки в линейной модели, в маршрут не выводится
+        NONE = 0,
+        WAIT,
+        BUS,
+        // Ожидание и поездка одним ребром (модель MERGED_STOPS)
+        WAIT_AND_BUS,
+    };
+
+    // Описание ребра графа для вывода маршрута, хранится в массиве по EdgeId.
+    // Остановка и автобус - номера в getStopNames() и getBusNames(),
+    // время ожидания всегда равно wait_time
+    struct EdgeInfo
+    {
+        EdgeKind kind = EdgeKind::NONE;
+        uint32_t stop = 0;
+        uint32_t bus = 0;
+        uint32_t span_count = 0;
+        double time = 0.0;
+        // Номер первой остановки поездки в маршруте автобуса, у некольцевого
+        // обратное направление нумеруется после прямого
+        uint32_t position = 0;
+    };
+
+    using RouteItem = domain::RouteItem;
+
+    // Остановки, автобусы и перегоны, закрытые для одного запроса
+    struct RouteExclusions
+    {
+        // Перегон автобуса между соседними остановками в направлении
+        // from -> to, без имени автобуса - перегон всех автобусов
+        struct Segment
+        {
+            std::string_view bus;
+            std::string_view from;
+            std::string_view to;
+        };
+
+        std::vector<std::string_view> stops;
+        std::vector<std::string_view> buses;
+        std::vector<Segment> segments;
+    };
+
+    // Настройки одного запроса вместо bus_wait_time и bus_velocity базы:
+    // ожидание в минутах, скорость в км/ч. Веса рёбер пересчитываются при
+    // поиске из времени проезда, сохранённого в EdgeInfo
+    struct RouteProfile
+    {
+        std::optional<double> wait_time;
+        std::optional<double> velocity;
+    };
+
+    // Исключения или профиль одного запроса, которые режим маршрутизатора
+    // не поддерживает или которые заданы неверно
+    class RouteOptionsError : public std::invalid_argument
+    {
+    public:
+        using std::invalid_argument::invalid_argument;
+    };
+
+    enum class RouterMode
+    {
+        PRECOMPUTE = 0,
+        ON_DEMAND,
+        // Поиск по раундам прямо по маршрутам автобусов, граф не строится
+        RAPTOR,
+        // Иерархия сжатий: предподсчёт при построении базы, быстрые запросы
+        CONTRACTION_HIERARCHY,
+        // A* с нижней оценкой по расстоянию до цели по прямой
+        A_STAR,
+        // A* с оценкой по ориентирам, выбранным при построении базы
+        ALT,
+        // Метки хабов: время в пути без поиска по графу, маршрут -
+        // A* с точной оценкой по меткам
+        HUB_LABELS,
+        // Строки таблицы маршрутов считаются при первом запросе из вершины
+        // и хранятся в кэше ограниченного размера
+        LAZY,
+        // Многоуровневый оверлей: разбиение на клетки - при построении базы,
+        // клики клеток - при загрузке и смене времени ожидания и скорости
+        OVERLAY,
+    };
+
+    enum class GraphModel
+    {
+        // Пара вершин (ожидание, посадка) на остановку и ребро на каждую
+        // пару остановок каждого автобуса: O(n^2) рёбер на маршрут
+        STOP_PAIRS = 0,
+        // Вершина на остановку и вершина на каждую позицию автобуса в
+        // маршруте, рёбра посадки, перегона и высадки: O(n) рёбер на маршрут
+        LINE,
+        // Как STOP_PAIRS, но одна вершина на остановку: ожидание входит
+        // в вес рёбер автобусов, отправляющихся с остановки
+        MERGED_STOPS,
+    };
+
+    // Тип весов таблицы маршрутов в режиме PRECOMPUTE
+    enum class TableWeightFormat
+    {
+        DOUBLE = 0,
+        // uint32_t в единицах трети времени проезда одного метра: при целых
+        // расстояниях, скорости и времени ожидания веса точные, а таблица
+        // вдвое компактнее. Если самый длинный маршрут не помещается,
+        // таблица строится в DOUBLE
+        FIXED_POINT,
+    };
 
     TransportRouter();
 
     void setInitSetting(bool value);
 
+    TransportRouter &setRouterMode(RouterMode mode);
+
+    RouterMode getRouterMode() const;
+
+    TransportRouter &setGraphModel(GraphModel model);
+
+    GraphModel getGraphModel() const;
+
+    TransportRouter &setAllPairsAlgorithm(graph::AllPairsAlgorithm algorithm);
+
+    graph::AllPairsAlgorithm getAllPairsAlgorithm() const;
+
+    TransportRouter &setBuildThreads(size_t thread_count);
+
+    size_t getBuildThreads() const;
+
+    TransportRouter &setLandmarkCount(size_t landmark_count);
+
+    size_t getLandmarkCount() const;
+
+    TransportRouter &setRowCacheBytes(size_t bytes);
+
+    size_t getRowCacheBytes() const;
+
+    TransportRouter &setTableWeightFormat(TableWeightFormat format);
+
+    TableWeightFormat getTableWeightFormat() const;
+
+    // Наибольшие размеры клеток уровней оверлея, снизу вверх
+    TransportRouter &setOverlayCellSizes(std::vector<size_t> sizes);
+
+    const std::vector<size_t> &getOverlayCellSizes() const;
+
     TransportRouter &setWaitTime(int time);
 
     TransportRouter &setVelocity(int velocity);
 
+    TransportRouter &setVelocityInMetersPerMinute(double velocity);
+
     void createGraph(const TransportCatalogue &_catalogue);
 
+    // Изменение состава автобусов без пересборки базы. _buses - новый полный
+    // список автобусов, автобусы и имена живут не меньше маршрутизатора.
+    // В моделях STOP_PAIRS и MERGED_STOPS автобусы проходят только через
+    // остановки, у которых уже есть вершины. Меняются только отличающиеся
+    // рёбра: таблица маршрутов и кэш строк восстанавливаются частично,
+    // предподсчёт CH, ALT и меток хабов строится заново. Линейный граф и
+    // RAPTOR перестраиваются по справочнику целиком.
+    void updateBuses(const TransportCatalogue &_catalogue,
+                     const std::vector<const domain::Bus *> &_buses);
+
+    // Новые время ожидания (мин) и скорость (км/ч) без пересборки базы;
+    // отсутствующее значение остаётся прежним, при совпадении с прежними
+    // ничего не делается. Веса рёбер пересчитываются по времени поездок
+    // из EdgeInfo. В режиме OVERLAY пересчитываются только клики клеток,
+    // ON_DEMAND, A_STAR, LAZY и RAPTOR предподсчёта не имеют. Предподсчёт
+    // PRECOMPUTE, CONTRACTION_HIERARCHY, ALT и HUB_LABELS строится заново
+    // только с _allow_rebuild, иначе std::invalid_argument
+    void updateSettings(const TransportCatalogue &_catalogue,
+                        std::optional<int> _wait_time, std::optional<int> _velocity,
+                        bool _allow_rebuild);
+
+    // Соединения рейсов по расписаниям автобусов для маршрутов со временем
+    // отправления, строятся при каждой загрузке базы
+    void createTimetable(const TransportCatalogue &_catalogue);
+
+    // Рёбра и маршруты автобусов для исключений в запросах, строятся при
+    // каждой загрузке базы и после обновления автобусов
+    void createBusIndex(const TransportCatalogue &_catalogue);
+
     std::optional<std::pair<double, std::vector<RouteItem>>>
     buildRoute(std::string_view _from, std::string_view _to) const;
 
+    // Самое раннее прибытие по расписаниям при отправлении не раньше
+    // _departure_time (минуты от начала суток), в любом режиме маршрутизатора
+    std::optional<std::pair<double, std::vector<RouteItem>>>
+    buildRoute(std::string_view _from, std::string_view _to, double _departure_time) const;
+
+    // Маршрут в обход _exclusions и с настройками _profile поиском Дейкстры
+    // по графу, предподсчитанные структуры не меняются. На закрытой остановке
+    // нельзя сесть, выйти или пересесть, проезжать её можно. Перегоны
+    // сверяются с маршрутами из createBusIndex(). Без исключений и
+    // настроек - обычный buildRoute
+    std::optional<std::pair<double, std::vector<RouteItem>>>
+    buildRoute(std::string_view _from, std::string_view _to,
+               const RouteExclusions &_exclusions,
+               const RouteProfile &_profile) const;
+
+    // Только время в пути, без состава маршрута
+    std::optional<double> computeTravelTime(std::string_view _from, std::string_view _to) const;
+
+    // Остановки и время в пути до них
+    using Isochrone = std::vector<std::pair<std::string_view, double>>;
+
+    // Остановки, до которых из _from можно доехать не дольше _max_time,
+    // по возрастанию времени. Поиск ограничен _max_time и переиспользует
+    // буферы между запросами
+    Isochrone buildIsochrone(std::string_view _from, double _max_time) const;
+
+    using RouteMatrix = std::vector<std::optional<std::pair<double, std::vector<RouteItem>>>>;
+
+    // Маршруты от каждой остановки _origins до каждой остановки _destinations,
+    // по строке на остановку отправления. Поиски общие для строки, а в иерархии
+    // сжатий - для всей матрицы. Без _with_items состав маршрутов пустой
+    RouteMatrix buildRouteMatrix(const std::vector<std::string_view> &_origins,
+                                 const std::vector<std::string_view> &_destinations,
+                                 bool _with_items) const;
+
     std::pair<double, double> getSettings() const;
 
     graph::Router<double> *getInternalRouter();
 
     const graph::Router<double> *getInternalRouter() const;
 
+    graph::Router<double, uint32_t> *getFixedPointRouter();
+
+    const graph::Router<double, uint32_t> *getFixedPointRouter() const;
+
+    const graph::ContractionHierarchy<double> *getContractionHierarchy() const;
+
+    // Восстанавливает иерархию сжатий по сохранённым рангам и сокращениям
+    void loadContractionHierarchy(std::vector<uint32_t> _ranks,
+                                  std::vector<graph::ContractionHierarchy<double>::Shortcut> _shortcuts);
+
     graph::DirectedWeightedGraph<double> &getGraph();
 
     const graph::DirectedWeightedGraph<double> &getGraph() const;
@@ -45,64 +274,243 @@ public:
 
     const std::unordered_map<std::string_view, VertexIds> &getVertexes() const;
 
-    std::unordered_map<graph::EdgeId, domain::WaitInfo> &getWaitEdges();
+    std::vector<EdgeInfo> &getEdgesInfo();
+
+    const std::vector<EdgeInfo> &getEdgesInfo() const;
+
+    std::vector<std::string_view> &getStopNames();
+
+    const std::vector<std::string_view> &getStopNames() const;
+
+    std::vector<std::string_view> &getBusNames();
+
+    const std::vector<std::string_view> &getBusNames() const;
+
+    std::vector<geo::Coordinates> &getVertexCoordinates();
+
+    const std::vector<geo::Coordinates> &getVertexCoordinates() const;
+
+    TransportRouter &setMinTimePerMeter(double time);
+
+    double getMinTimePerMeter() const;
+
+    const graph::Landmarks<double> *getLandmarks() const;
+
+    // Восстанавливает ориентиры по сохранённым таблицам весов
+    void loadLandmarks(std::vector<graph::VertexId> _landmarks,
+                       std::vector<double> _distances_from,
+                       std::vector<double> _distances_to);
+
+    const graph::HubLabels<double> *getHubLabels() const;
 
-    const std::unordered_map<graph::EdgeId, domain::WaitInfo> &getWaitEdges() const;
+    // Восстанавливает метки хабов по сохранённым данным
+    void loadHubLabels(graph::HubLabels<double>::Labels _out_labels,
+                       graph::HubLabels<double>::Labels _in_labels);
 
-    std::unordered_map<graph::EdgeId, domain::BusRouteInfo> &getBusEdges();
+    // Число вершин, обработанных последним поиском (ON_DEMAND, A_STAR, ALT,
+    // HUB_LABELS и изохроны)
+    size_t getLastSettledCount() const;
 
-    const std::unordered_map<graph::EdgeId, domain::BusRouteInfo> &getBusEdges() const;
+    const graph::MultilevelOverlay<double> *getOverlay() const;
 
-    void setRouterWithNewGraph();
+    // Восстанавливает оверлей по сохранённым разбиению и кликам
+    void loadOverlay(graph::MultilevelOverlay<double>::Partition _partition,
+                     const std::vector<graph::MultilevelOverlay<double>::Cliques> &_cliques);
+
+    // _compute_routes == false - таблица маршрутов не считается,
+    // а будет заполнена извне (при десериализации)
+    void setRouterWithNewGraph(bool _compute_routes = true);
 
 private:
 
     bool is_init_ = false;
     double wait_time_ = 0.0;
     double velocity_ = 0.0;
+    // Скорость, при которой посчитано время поездок в EdgeInfo, и множитель
+    // этого времени при текущей скорости после updateSettings
+    double edge_velocity_ = 0.0;
+    double ride_time_scale_ = 1.0;
+    RouterMode router_mode_ = RouterMode::PRECOMPUTE;
+    GraphModel graph_model_ = GraphModel::STOP_PAIRS;
+    graph::AllPairsAlgorithm all_pairs_algorithm_ = graph::AllPairsAlgorithm::FLOYD_WARSHALL;
+    size_t build_threads_ = 0;
+    size_t landmark_count_ = 8;
+    size_t row_cache_bytes_ = 64U << 20U;
+    TableWeightFormat table_weight_format_ = TableWeightFormat::DOUBLE;
+    std::vector<size_t> overlay_cell_sizes_ = {32, 512, 8192};
+    // Потоки рёбер автобусов, создаются при первой сборке и переиспользуются
+    // при обновлениях автобусов
+    std::unique_ptr<parallel::ThreadPool> build_pool_ = nullptr;
 
     graph::DirectedWeightedGraph<double> graph_;
     std::unique_ptr<graph::Router<double>> router_ = nullptr;
+    std::unique_ptr<graph::Router<double, uint32_t>> fixed_point_router_ = nullptr;
+    std::unique_ptr<graph::DijkstraRouter<double>> dijkstra_router_ = nullptr;
+    std::unique_ptr<graph::ContractionHierarchy<double>> contraction_hierarchy_ = nullptr;
+    std::unique_ptr<graph::Landmarks<double>> landmarks_ = nullptr;
+    std::unique_ptr<graph::HubLabels<double>> hub_labels_ = nullptr;
+    std::unique_ptr<graph::LazyRouter<double>> lazy_router_ = nullptr;
+    std::unique_ptr<graph::MultilevelOverlay<double>> overlay_ = nullptr;
+    RaptorRouter raptor_router_;
+    CsaRouter csa_router_;
     std::unordered_map<std::string_view, VertexIds> vertexes_;
 
     graph::VertexId vertexes_counter_ = 0;
 
-    std::unordered_map<graph::EdgeId, domain::WaitInfo> wait_edges_;
+    std::vector<EdgeInfo> edges_info_;
+
+    std::vector<std::string_view> stop_names_;
+
+    std::vector<std::string_view> bus_names_;
+
+    // По номеру автобуса: его рёбра в графе и номера остановок маршрута
+    // в нумерации EdgeInfo::position
+    std::vector<std::vector<graph::EdgeId>> bus_edges_;
+
+    std::vector<std::vector<uint32_t>> bus_routes_;
+
+    using StagedEdges = std::vector<std::pair<graph::Edge<double>, EdgeInfo>>;
+
+    // Рёбра автобусов до добавления в граф: из параллельных рёбер между
+    // одной парой вершин остаётся самое лёгкое, индекс - по паре вершин
+    StagedEdges staged_edges_;
+
+    std::unordered_map<uint64_t, size_t> staged_edge_index_;
+
+    // Для A* и разбиения оверлея: координаты остановки каждой вершины;
+    // для A* ещё нижняя оценка времени проезда одного метра по прямой
+    std::vector<geo::Coordinates> vertex_coordinates_;
+
+    double min_time_per_meter_ = 0.0;
+
+    std::optional<graph::Router<double>::RouteInfo>
+    buildInternalRoute(graph::VertexId _from, graph::VertexId _to) const;
+
+    std::vector<std::optional<graph::Router<double>::RouteInfo>>
+    buildInternalRouteMatrix(const std::vector<graph::VertexId> &_from,
+                             const std::vector<graph::VertexId> &_to,
+                             bool _with_edges) const;
+
+    // Рёбра поездок через один из _segments в _blocked_edges
+    void blockRidesThroughSegments(const std::vector<RouteExclusions::Segment> &_segments,
+                                   std::unordered_set<graph::EdgeId> &_blocked_edges) const;
 
-    std::unordered_map<graph::EdgeId, domain::BusRouteInfo> bus_edges_;
+    // Время и состав маршрута по рёбрам графа
+    std::pair<double, std::vector<RouteItem>>
+    makeRoute(const graph::Router<double>::RouteInfo &_route_info) const;
 
+    // То же с ожиданием _wait_time и временем поездок, умноженным на _ride_time_scale
+    std::pair<double, std::vector<RouteItem>>
+    makeRoute(const graph::Router<double>::RouteInfo &_route_info,
+              double _wait_time, double _ride_time_scale) const;
+
+    parallel::ThreadPool &getBuildPool();
+
+    void createStopPairsGraph(const TransportCatalogue &_catalogue);
+
+    void createLineGraph(const TransportCatalogue &_catalogue);
+
+    graph::EdgeId addEdge(const graph::Edge<double> &_edge, const EdgeInfo &_info);
+
+    void stageEdge(const graph::Edge<double> &_edge, const EdgeInfo &_info);
+
+    void addStagedEdges();
+
+    void bindVertexToStop(graph::VertexId _vertex, const domain::Stop &_stop);
+
+    void computeMinTimePerMeter(const TransportCatalogue &_catalogue,
+                                const std::vector<const domain::Bus *> &_buses);
+
+    // Рёбра автобусов моделей STOP_PAIRS и MERGED_STOPS в staged_edges_,
+    // _bus_indexes - номера автобусов в getBusNames()
+    void stageBusEdges(const TransportCatalogue &_catalogue,
+                       const std::vector<const domain::Bus *> &_buses,
+                       const std::vector<uint32_t> &_bus_indexes);
+
+    // Рёбра одного автобуса строятся в собственный буфер _edges, поэтому
+    // автобусы обрабатываются параллельно
     template <typename It>
     void createEdgeBetweenStops(It begin, It end,
-                                std::string_view _bus_name,
-                                const TransportCatalogue &_catalogue);
+                                uint32_t _bus, uint32_t _first_position,
+                                const TransportCatalogue &_catalogue,
+                                StagedEdges &_edges) const;
+
+    template <typename It>
+    void createLineEdges(It begin, It end,
+                         uint32_t _bus, uint32_t _first_position,
+                         graph::VertexId _first_on_bus,
+                         const TransportCatalogue &_catalogue,
+                         StagedEdges &_edges);
 };
 
 template<typename It>
 void TransportRouter::createEdgeBetweenStops(It begin, It end,
-                                             std::string_view _bus_name,
-                                             const TransportCatalogue &_catalogue)
+                                             uint32_t _bus, uint32_t _first_position,
+                                             const TransportCatalogue &_catalogue,
+                                             StagedEdges &_edges) const
 {
+    const bool is_merged = graph_model_ == GraphModel::MERGED_STOPS;
+    const double board_weight = is_merged ? wait_time_ : 0.0;
+
     for (auto from_it = begin; from_it != std::prev(end); ++from_it)
     {
         double weight = 0.0;
         int span_count = 0;
+        const auto position = static_cast<uint32_t>(_first_position + std::distance(begin, from_it));
 
         for (auto to_it = std::next(from_it); to_it != end; ++to_it)
         {
-            std::string_view from_name = *from_it;
-            const graph::VertexId from_idx = vertexes_.at(from_name).moving;
+            const VertexIds &from_ids = vertexes_.at(*from_it);
+            const graph::VertexId from_idx = from_ids.moving;
 
             std::string_view to_name = *to_it;
             const graph::VertexId to_idx = vertexes_.at(to_name).waiting;
 
             weight += _catalogue.
-                    getDistancesBetweenStops({*prev(to_it), *(to_it)}).value() / this->velocity_;
+                    getDistancesBetweenStops({*prev(to_it), *(to_it)}).value() / this->edge_velocity_;
             ++span_count;
 
-            auto bus_edge_id = graph_.AddEdge({from_idx, to_idx, weight});
+            _edges.emplace_back(graph::Edge<double>{from_idx, to_idx,
+                                                    board_weight + weight * ride_time_scale_},
+                                EdgeInfo{is_merged ? EdgeKind::WAIT_AND_BUS : EdgeKind::BUS,
+                                         from_ids.stop, _bus, static_cast<uint32_t>(span_count), weight,
+                                         position});
+        }
+    }
+}
+
+template<typename It>
+void TransportRouter::createLineEdges(It begin, It end,
+                                      uint32_t _bus, uint32_t _first_position,
+                                      graph::VertexId _first_on_bus,
+                                      const TransportCatalogue &_catalogue,
+                                      StagedEdges &_edges)
+{
+    graph::VertexId on_bus = _first_on_bus;
+    for (auto it = begin; it != end; ++it, ++on_bus)
+    {
+        const VertexIds &stop_ids = vertexes_.at(*it);
+        const graph::VertexId stop_vertex = stop_ids.waiting;
+        bindVertexToStop(on_bus, *_catalogue.findStop(*it));
 
-            bus_edges_[bus_edge_id] = {_bus_name, span_count, weight};
+        if (it != begin)
+        {
+            _edges.emplace_back(graph::Edge<double>{on_bus, stop_vertex, 0.0}, EdgeInfo{});
+        }
+
+        if (std::next(it) == end)
+        {
+            continue;
         }
+
+        _edges.emplace_back(graph::Edge<double>{stop_vertex, on_bus, wait_time_},
+                            EdgeInfo{EdgeKind::WAIT, stop_ids.stop});
+
+        const double ride_time = _catalogue.
+                getDistancesBetweenStops({*it, *std::next(it)}).value() / this->edge_velocity_;
+        _edges.emplace_back(graph::Edge<double>{on_bus, on_bus + 1, ride_time * ride_time_scale_},
+                            EdgeInfo{EdgeKind::BUS, stop_ids.stop, _bus, 1, ride_time,
+                                     _first_position + (on_bus - _first_on_bus)});
     }
 }
 